@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hashmap.h"
+
+/*
+ * Collision flood against HashMap. Every flood key is a row of blocks "Bc" or "ab", two blocks that the
+ * polynomial hash of the original tracker (sum of (c - 'a' + 1)*31^i mod 1000000007) maps to the same
+ * value, so all 2^blocks keys landed in one chain there. As many random keys of the same length are the
+ * baseline. For both sets the bench loads a HashMap and reports the time per insert and per lookup and the
+ * mean and longest probe length in groups. It fails if the flood keys probe longer than the random keys.
+ *
+ *   flood_bench [blocks] [lookup rounds]
+ */
+#define BENCH_BLOCKS 16
+#define BENCH_ROUNDS 20
+#define BENCH_MAX_BLOCKS 20
+#define LEGACY_MOD 1000000007LL
+#define PROBE_SLACK 1.5 // Mean probe length of the flood keys may exceed the baseline by this factor
+
+typedef struct{
+    double insertNanos; // Per key
+    double lookupNanos; // Per key
+    double meanProbe; // Groups
+    int maxProbe; // Groups
+}FloodResult;
+
+/**
+ * @brief Read a monotonic clock
+ * @return The current time in nanoseconds
+ */
+static double nowNanos(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1e9 + ts.tv_nsec;
+}
+
+/**
+ * @brief The polynomial hash the tracker used before the seeded hash, without its int overflow
+ * @param key The key
+ * @return The hash of the key
+ */
+static long long legacyHash(const char *key){
+    long long hash = 0, p = 1;
+    for (; *key; key++){
+        hash = ((hash + (*key - 'a' + 1)*p) % LEGACY_MOD + LEGACY_MOD) % LEGACY_MOD;
+        p = p*31 % LEGACY_MOD;
+    }
+    return hash;
+}
+
+/**
+ * @brief Allocate an array of keys of the same length
+ * @param count The number of keys
+ * @param length The length of every key
+ * @return The keys, each one NUL terminated
+ */
+static char** allocateKeys(int count, int length){
+    char **keys = malloc(count*sizeof(char *));
+    if (!keys){
+        printf("Memory allocation failed!");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < count; i++){
+        keys[i] = malloc(length + 1);
+        if (!keys[i]){
+            printf("Memory allocation failed!");
+            exit(EXIT_FAILURE);
+        }
+        keys[i][length] = '\0';
+    }
+    return keys;
+}
+
+/**
+ * @brief Free an array of keys
+ * @param keys The keys
+ * @param count The number of keys
+ */
+static void freeKeys(char **keys, int count){
+    for (int i = 0; i < count; i++)
+        free(keys[i]);
+    free(keys);
+}
+
+/**
+ * @brief Load a map with keys, look every key up a number of times and measure the probe lengths
+ * @param keys The keys
+ * @param count The number of keys
+ * @param rounds How many times every key is looked up
+ * @return The timings and probe lengths
+ */
+static FloodResult runSet(char **keys, int count, int rounds){
+    HashMap map;
+    FloodResult result = {0, 0, 0, 0};
+    long long found = 0, probes = 0;
+
+    initializeMap(&map, 0, sizeof(int)); // Grows while it is loaded, like the symbol map
+    double start = nowNanos();
+    for (int i = 0; i < count; i++)
+        insert(&map, keys[i], &i);
+    result.insertNanos = (nowNanos() - start)/count;
+
+    start = nowNanos();
+    for (int r = 0; r < rounds; r++){
+        for (int i = 0; i < count; i++)
+            found += get(&map, keys[i]) != NULL;
+    }
+    result.lookupNanos = (nowNanos() - start)/((double)count*rounds);
+
+    for (int i = 0; i < count; i++){
+        int length = probeLength(&map, keys[i]);
+        probes += length;
+        if (length > result.maxProbe)
+            result.maxProbe = length;
+    }
+    result.meanProbe = (double)probes/count;
+
+    if (found != (long long)count*rounds)
+        printf("HashMap lost %lld lookups\n", (long long)count*rounds - found);
+    freeMap(&map, NULL);
+    return result;
+}
+
+int main(int argc, char **argv){
+    int blocks = argc > 1 ? atoi(argv[1]) : BENCH_BLOCKS;
+    int rounds = argc > 2 ? atoi(argv[2]) : BENCH_ROUNDS;
+
+    if (blocks < 1 || blocks > BENCH_MAX_BLOCKS || rounds < 1){
+        fprintf(stderr, "usage: flood_bench [blocks, 1 to %d] [lookup rounds]\n", BENCH_MAX_BLOCKS);
+        return 2;
+    }
+
+    int count = 1 << blocks;
+    int length = 2*blocks;
+    char **flood = allocateKeys(count, length);
+    char **random = allocateKeys(count, length);
+    unsigned long long seed = 0x9e3779b97f4a7c15ULL;
+    const char *letters = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+    for (int i = 0; i < count; i++){
+        for (int b = 0; b < blocks; b++) // Bit b of i picks the block
+            memcpy(flood[i] + 2*b, (i >> b) & 1 ? "Bc" : "ab", 2);
+        for (int c = 0; c < length; c++){
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            random[i][c] = letters[seed % 52];
+        }
+    }
+
+    int legacyCollisions = 0;
+    long long legacy = legacyHash(flood[0]);
+    for (int i = 0; i < count; i++)
+        legacyCollisions += legacyHash(flood[i]) == legacy;
+
+    printf("%d keys of %d characters, %d lookups per key\n", count, length, rounds);
+    printf("flood keys sharing one polynomial hash: %d\n\n", legacyCollisions);
+
+    FloodResult floodResult = runSet(flood, count, rounds);
+    FloodResult randomResult = runSet(random, count, rounds);
+
+    printf("keys     ns/insert  ns/lookup  mean probe  max probe\n");
+    printf("flood   %10.1f %10.1f %11.3f %10d\n", floodResult.insertNanos, floodResult.lookupNanos, floodResult.meanProbe, floodResult.maxProbe);
+    printf("random  %10.1f %10.1f %11.3f %10d\n", randomResult.insertNanos, randomResult.lookupNanos, randomResult.meanProbe, randomResult.maxProbe);
+
+    freeKeys(flood, count);
+    freeKeys(random, count);
+
+    if (floodResult.meanProbe > randomResult.meanProbe*PROBE_SLACK){
+        printf("\nFlood keys probe %.2f times as many groups as random keys\n", floodResult.meanProbe/randomResult.meanProbe);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,230 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include "concurrent_map.h"
+#include "hashmap.h"
+
+/*
+ * Reader scaling of ConcurrentMap. Every round preloads the same keys, then 1 to BENCH_MAX_READERS
+ * threads look up random keys while one writer keeps replacing values, inserting and deleting keys. Every
+ * value a reader gets is checked against its key. A single-threaded HashMap lookup loop is the baseline.
+ * The readers stand for parser threads resolving names, queries do not run on other threads.
+ *
+ *   map_bench [keys] [milliseconds per round]
+ */
+#define BENCH_MAX_READERS 64
+#define BENCH_KEYS 100000
+#define BENCH_MILLISECONDS 300
+
+typedef struct{
+    uint32_t id; // Index of the key, readers check it
+    uint32_t generation; // Bumped by the writer
+}BenchValue;
+
+typedef struct{
+    ConcurrentMap *map;
+    char **keys;
+    int keyCount;
+    int reader; // Reader slot
+    uint64_t seed;
+    long long lookups;
+    long long errors;
+}ReaderArgs;
+
+typedef struct{
+    ConcurrentMap *map;
+    char **keys;
+    int keyCount;
+    long long writes;
+}WriterArgs;
+
+static atomic_int running;
+
+/**
+ * @brief Next value of a xorshift generator
+ * @param state The state, updated
+ * @return A random number
+ */
+static uint64_t nextRandom(uint64_t *state){
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+/**
+ * @brief Read a monotonic clock
+ * @return The current time in seconds
+ */
+static double nowSeconds(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+/**
+ * @brief Body of a reader thread, looks up random keys until the round ends
+ * @param argument The ReaderArgs
+ * @return NULL
+ */
+static void* readerMain(void *argument){
+    ReaderArgs *args = argument;
+    BenchValue value;
+
+    while (atomic_load_explicit(&running, memory_order_relaxed)){
+        for (int i = 0; i < 256; i++){
+            uint32_t id = nextRandom(&args->seed) % args->keyCount;
+            const char *key = args->keys[id];
+            if (!concurrentGet(args->map, args->reader, key, strlen(key), &value) || value.id != id)
+                args->errors++;
+        }
+        args->lookups += 256;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Body of the writer thread, replaces values of preloaded keys and inserts and deletes keys of its own
+ * @param argument The WriterArgs
+ * @return NULL
+ */
+static void* writerMain(void *argument){
+    WriterArgs *args = argument;
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    char scratch[32];
+    uint32_t generation = 0;
+
+    while (atomic_load_explicit(&running, memory_order_relaxed)){
+        uint32_t id = nextRandom(&seed) % args->keyCount;
+        BenchValue value = {id, ++generation};
+        concurrentPut(args->map, args->keys[id], strlen(args->keys[id]), &value);
+
+        int length = snprintf(scratch, sizeof(scratch), "churn%u", generation % 1024); // Never looked up by readers
+        if (!concurrentDelete(args->map, scratch, length))
+            concurrentFindOrInsert(args->map, scratch, length, &value, NULL, NULL);
+        args->writes += 2;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Run one round with a number of readers and print its line of the table
+ * @param keys The keys
+ * @param keyCount The number of keys
+ * @param readerCount The number of reader threads
+ * @param milliseconds The length of the round
+ * @return The number of wrong lookups
+ */
+static long long runRound(char **keys, int keyCount, int readerCount, int milliseconds){
+    ConcurrentMap map;
+    ReaderArgs readers[BENCH_MAX_READERS];
+    pthread_t threads[BENCH_MAX_READERS];
+    WriterArgs writer = {&map, keys, keyCount, 0};
+    pthread_t writerThread;
+
+    initializeConcurrentMap(&map, 0, sizeof(BenchValue)); // Grows while it is loaded
+    for (int i = 0; i < keyCount; i++){
+        BenchValue value = {i, 0};
+        concurrentFindOrInsert(&map, keys[i], strlen(keys[i]), &value, NULL, NULL);
+    }
+
+    atomic_store(&running, 1);
+    for (int i = 0; i < readerCount; i++){
+        readers[i] = (ReaderArgs){&map, keys, keyCount, registerMapReader(&map), 0x2545f4914f6cdd1dULL + i, 0, 0};
+        pthread_create(&threads[i], NULL, readerMain, &readers[i]);
+    }
+    pthread_create(&writerThread, NULL, writerMain, &writer);
+
+    double start = nowSeconds();
+    struct timespec round = {milliseconds/1000, (milliseconds%1000)*1000000L};
+    nanosleep(&round, NULL);
+    atomic_store(&running, 0);
+
+    long long lookups = 0, errors = 0;
+    for (int i = 0; i < readerCount; i++){
+        pthread_join(threads[i], NULL);
+        lookups += readers[i].lookups;
+        errors += readers[i].errors;
+    }
+    pthread_join(writerThread, NULL);
+    double elapsed = nowSeconds() - start;
+
+    printf("%7d %14.2f %18.2f %14.2f %8lld\n", readerCount, lookups/elapsed/1e6, lookups/elapsed/1e6/readerCount, writer.writes/elapsed/1e6, errors);
+    freeConcurrentMap(&map, NULL);
+    return errors;
+}
+
+/**
+ * @brief Look up random keys in a HashMap on one thread, with no writer
+ * @param keys The keys
+ * @param keyCount The number of keys
+ * @param milliseconds The length of the run
+ */
+static void runBaseline(char **keys, int keyCount, int milliseconds){
+    HashMap map;
+    uint64_t seed = 0x2545f4914f6cdd1dULL;
+    long long lookups = 0;
+
+    initializeMap(&map, 0, sizeof(BenchValue));
+    for (int i = 0; i < keyCount; i++){
+        BenchValue value = {i, 0};
+        insert(&map, keys[i], &value);
+    }
+
+    double start = nowSeconds();
+    double elapsed;
+    do{
+        for (int i = 0; i < 256; i++){
+            uint32_t id = nextRandom(&seed) % keyCount;
+            BenchValue *value = get(&map, keys[id]);
+            if (!value || value->id != id)
+                printf("HashMap lost key %s\n", keys[id]);
+        }
+        lookups += 256;
+        elapsed = nowSeconds() - start;
+    }while (elapsed < milliseconds/1000.0);
+
+    printf("HashMap, 1 thread, no writer: %.2f M lookups/s\n\n", lookups/elapsed/1e6);
+    freeMap(&map, NULL);
+}
+
+int main(int argc, char **argv){
+    int keyCount = argc > 1 ? atoi(argv[1]) : BENCH_KEYS;
+    int milliseconds = argc > 2 ? atoi(argv[2]) : BENCH_MILLISECONDS;
+    long long errors = 0;
+
+    if (keyCount < 1 || milliseconds < 1){
+        fprintf(stderr, "usage: map_bench [keys] [milliseconds per round]\n");
+        return 2;
+    }
+
+    char **keys = malloc(keyCount*sizeof(char *));
+    if (!keys){
+        printf("Memory allocation failed!");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < keyCount; i++){
+        char buffer[32];
+        int length = snprintf(buffer, sizeof(buffer), "key%d", i);
+        keys[i] = malloc(length + 1);
+        if (!keys[i]){
+            printf("Memory allocation failed!");
+            exit(EXIT_FAILURE);
+        }
+        memcpy(keys[i], buffer, length + 1);
+    }
+
+    printf("%d keys, %d ms per round\n", keyCount, milliseconds);
+    runBaseline(keys, keyCount, milliseconds);
+    printf("readers  M lookups/s  M lookups/s/reader  M writes/s   errors\n");
+    for (int readers = 1; readers <= BENCH_MAX_READERS; readers *= 2)
+        errors += runRound(keys, keyCount, readers, milliseconds);
+
+    for (int i = 0; i < keyCount; i++)
+        free(keys[i]);
+    free(keys);
+    return errors != 0;
+}
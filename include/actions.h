@@ -3,16 +3,25 @@
 
 #include "structures.h"
 #include "hashmap.h"
+#include "typed_maps.h"
+#include "brew_index.h"
 
-void loot(HashMap *map, PairArray *lootArray);
-void trade(HashMap *ingredients, HashMap *trophies, PairArray *requiredIngredients, PairArray *requiredTrophies);
-void brew(HashMap *potions, HashMap *ingredients, char *potion);
-void learnPotionRecipe(HashMap *potions, char *potion, PairArray *ingredients);
-void encounter(HashMap *monsters, HashMap *potions, HashMap *trophies, char *monster);
+void loot(CounterTable *map, PairArray *lootArray);
+int trade(CounterTable *ingredients, CounterTable *trophies, PairArray *requiredIngredients, PairArray *requiredTrophies);
+void lootStaged(CounterTable *ingredients, const StagedPairs *lootTotals);
+int tradeStaged(CounterTable *ingredients, CounterTable *trophies, const StagedPairs *ingredientTotals, const StagedPairs *trophyTotals);
+int64_t brewPotion(PotionTable *potions, CounterTable *ingredients, Symbol potion, int64_t times);
+int64_t brew(PotionTable *potions, CounterTable *ingredients, Symbol potion, int times);
+int addPotionRecipe(PotionTable *potions, BrewIndex *brewIndex, Symbol potion, const PairArray *ingredients);
+int learnPotionRecipe(PotionTable *potions, BrewIndex *brewIndex, Symbol potion, const PairArray *ingredients);
+int defeatMonster(BestiaryTable *monsters, PotionTable *potions, CounterTable *trophies, Symbol monster);
+int encounter(BestiaryTable *monsters, PotionTable *potions, CounterTable *trophies, Symbol monster);
 
 
-void learnSign(HashMap *monsters, char *monster, char *sign);
-void learnPotion(HashMap *monsters, char *monster, char *potion);
+int addEffectiveSign(BestiaryTable *monsters, Symbol monster, Symbol sign);
+int addEffectivePotion(BestiaryTable *monsters, Symbol monster, Symbol potion);
+int learnSign(BestiaryTable *monsters, Symbol monster, Symbol sign);
+int learnPotion(BestiaryTable *monsters, Symbol monster, Symbol potion);
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,27 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_BLOCK_SIZE (64*1024) // Size of the first block, enough for the structures of a typical line
+#define ARENA_ALIGNMENT 16 // Every allocation is aligned for any type
+
+typedef struct ArenaBlock{
+    struct ArenaBlock *next; // Block allocated after this one was full
+    size_t capacity; // Bytes in data
+    size_t used; // Bytes handed out
+    _Alignas(ARENA_ALIGNMENT) char data[];
+}ArenaBlock;
+
+typedef struct{
+    ArenaBlock *first; // Block that survives resets
+    ArenaBlock *current; // Block allocations are taken from
+}Arena;
+
+void initializeArena(Arena *arena);
+void* arenaAlloc(Arena *arena, size_t size);
+void resetArena(Arena *arena);
+void freeArena(Arena *arena);
+
+
+#endif
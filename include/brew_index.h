@@ -0,0 +1,29 @@
+#ifndef BREW_INDEX_H
+#define BREW_INDEX_H
+
+#include "typed_maps.h"
+
+typedef struct{
+    Symbol potion; // Potion whose recipe uses the ingredient
+    int slot; // Index of the ingredient among the folded ingredients of the recipe
+}RecipeUse;
+
+typedef struct{
+    RecipeUse *uses;
+    int size;
+    int capacity;
+}RecipeUses;
+
+typedef struct{
+    RecipeUses *byIngredient; // Recipes that use an ingredient, indexed by the symbol of the ingredient
+    int capacity;
+    PotionTable *potions;
+    CounterTable *ingredients; // Observed, every change of an ingredient updates the recipes that use it
+}BrewIndex;
+
+void initializeBrewIndex(BrewIndex *index, PotionTable *potions, CounterTable *ingredients);
+void indexRecipe(BrewIndex *index, Symbol potion);
+void freeBrewIndex(BrewIndex *index);
+
+
+#endif
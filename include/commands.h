@@ -0,0 +1,68 @@
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+#include "typed_maps.h"
+#include "lexer.h"
+#include "arena.h"
+#include "brew_index.h"
+
+#define MAX_PATTERN 10 // Longest pattern of a command, P_END included
+#define MAX_ARGUMENTS 2 // Most variable parts a command can have
+#define ANY_LENGTH 0x7fffffff // Maximum token count of a command that ends with a name or pairs
+#define MAX_BREWS 10000 // Largest N of "Geralt brews N X", every brew prints a line, larger counts are INVALID
+
+// Pattern elements, positive values are keywords that must appear as they are
+#define P_END 0 // End of the line
+#define P_WORD -1 // One word name
+#define P_NAME -2 // Name of one or more words, runs up to the element that follows it
+#define P_PAIRS -3 // Count and name pairs separated by commas, runs up to the element that follows it
+#define P_QMARK -4 // "?"
+#define P_NUMBER -5 // Positive number
+#define P_PATH -6 // Snapshot file name, one token of any characters but spaces, commas and "?"
+#define P_SKIP -7 // One word or number that must be there but is not an argument
+#define P_ATTACHED_QMARK -8 // "?" written right after the token before it, never the first element
+
+typedef struct Journal Journal;
+
+typedef struct{
+    CounterTable *ingredients;
+    CounterTable *trophies;
+    PotionTable *potions;
+    BestiaryTable *monsters;
+    BrewIndex *brewIndex; // Recipes per ingredient, observes ingredients
+    Journal *journal; // Log of the changes made by commands, NULL when there is none
+    const char *snapshotDirectory; // Directory of the files of Save and Load, NULL disables both commands
+}Inventory;
+
+typedef struct{
+    int start; // Index of the first token
+    int count; // Number of tokens
+    Token text; // Span of a P_WORD or P_NAME argument, the token of a P_NUMBER or P_PATH
+    Symbol symbol; // Symbol of a P_WORD or P_NAME argument looked up ahead of execution, NO_SYMBOL if it was not
+}Argument;
+
+typedef struct Command Command;
+
+typedef struct{
+    void (*handler)(Inventory *inventory, const Command *command, Arena *scratch);
+    int minTokens; // Token count rules, "?" included
+    int maxTokens;
+    int pattern[MAX_PATTERN]; // Terminated by P_END, a P_NAME or P_PAIRS must be followed by a keyword, "?" or P_END
+}CommandRule;
+
+struct Command{
+    const CommandRule *rule; // Row of the command table that matched
+    const char *line;
+    const Token *tokens;
+    Argument arguments[MAX_ARGUMENTS]; // Variable parts of the pattern in order
+};
+
+void initializeInventory(Inventory *inventory);
+void freeInventory(Inventory *inventory);
+void initializeCommandTable(void);
+int parseCommand(const char *line, const Token *tokens, int size, Command *command);
+void resolveArguments(Command *command, int reader);
+void executeCommand(Inventory *inventory, const Command *command, Arena *scratch);
+
+
+#endif
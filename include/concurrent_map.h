@@ -0,0 +1,61 @@
+#ifndef CONCURRENT_MAP_H
+#define CONCURRENT_MAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "epoch.h"
+
+#define CONCURRENT_STRIPES 64 // Writer locks, a key's stripe is picked by its hash
+#define CONCURRENT_INITIAL_BUCKETS 64 // Never fewer buckets than stripes, so every bucket has one stripe
+#define CONCURRENT_LOAD_FACTOR 1 // Keys per bucket after which the bucket array doubles
+#define CONCURRENT_ALIGNMENT 16 // Values are aligned for any type
+
+/*
+ * A HashMap for many threads. Keys hash into chains of nodes. Readers walk the chains without a lock and
+ * never wait, writers lock the stripe of the key, so writers of different stripes do not wait for each
+ * other either. A node is never changed once it is reachable: an update links a copy in its place,
+ * a delete unlinks it, and growing builds a new bucket array of copies. Whatever a writer unlinks is
+ * retired to the epochs of the map and freed once no reader can still see it. A key keeps its address
+ * from insert to delete, copies share it.
+ *
+ * The symbol table is its only user: the parser threads of --threads look names up while the executor
+ * interns. The tables behind queries are not concurrent, queries run on the executor one at a time.
+ */
+typedef struct ConcurrentNode{
+    _Atomic(struct ConcurrentNode *) next;
+    uint64_t hash;
+    char *key; // NUL terminated, shared by every copy of the node
+    size_t length;
+    _Alignas(CONCURRENT_ALIGNMENT) char value[];
+}ConcurrentNode;
+
+typedef struct{
+    size_t mask; // Number of buckets - 1, a power of two
+    _Atomic(ConcurrentNode *) buckets[];
+}ConcurrentTable;
+
+typedef struct{
+    _Alignas(EPOCH_LINE) pthread_mutex_t lock;
+}MapStripe;
+
+typedef struct{
+    _Atomic(ConcurrentTable *) table;
+    MapStripe stripes[CONCURRENT_STRIPES];
+    atomic_int size; // Number of keys
+    size_t valueSize;
+    uint64_t seed; // Hash seed, see processHashSeed
+    EpochDomain epochs;
+}ConcurrentMap;
+
+void initializeConcurrentMap(ConcurrentMap *map, int capacity, size_t valueSize);
+int registerMapReader(ConcurrentMap *map);
+int concurrentGet(ConcurrentMap *map, int reader, const char *key, size_t length, void *value);
+int concurrentFindOrInsert(ConcurrentMap *map, const char *key, size_t length, const void *value, void *found, const char **storedKey);
+void concurrentPut(ConcurrentMap *map, const char *key, size_t length, const void *value);
+int concurrentDelete(ConcurrentMap *map, const char *key, size_t length);
+void freeConcurrentMap(ConcurrentMap *map, void (*freeValue)(void *value));
+
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#define EPOCH_MAX_READERS 128 // Threads that may read one structure
+#define EPOCH_LINE 64 // Size of a cache line, every reader announces on its own line
+
+/*
+ * Epoch based reclamation. A reader announces the global epoch before it touches shared memory and
+ * withdraws when it is done, it never waits. A writer that unlinks memory retires it instead of freeing
+ * it. The global epoch only advances once every active reader announced the current one, and memory
+ * retired two epochs back is freed then, no reader can still hold it.
+ */
+typedef struct Retired{
+    struct Retired *next;
+    void *item;
+    void (*release)(void *item);
+}Retired;
+
+typedef struct{
+    _Alignas(EPOCH_LINE) atomic_uint_fast64_t state; // 0 when outside, otherwise the announced epoch * 2 + 1
+}EpochReader;
+
+typedef struct{
+    atomic_uint_fast64_t global;
+    atomic_int readerCount; // Readers registered so far
+    EpochReader readers[EPOCH_MAX_READERS];
+    pthread_mutex_t lock; // Serializes retiring and advancing
+    Retired *limbo[3]; // Memory retired in every epoch modulo 3
+}EpochDomain;
+
+void initializeEpochs(EpochDomain *domain);
+int registerEpochReader(EpochDomain *domain);
+void epochEnter(EpochDomain *domain, int reader);
+void epochExit(EpochDomain *domain, int reader);
+void epochRetire(EpochDomain *domain, void *item, void (*release)(void *item));
+void freeEpochs(EpochDomain *domain);
+
+
+#endif
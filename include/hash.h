@@ -0,0 +1,11 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+uint64_t hashBytes(const void *data, size_t len, uint64_t seed);
+uint64_t processHashSeed(void);
+
+
+#endif
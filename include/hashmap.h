@@ -2,32 +2,57 @@
 #define HASHMAP_H
 
 #include "stddef.h"
+#include <stdint.h>
 
-#define INITIAL_TABLE_SIZE 101
+#define INITIAL_TABLE_SIZE 16
 #define LOAD_FACTOR_THRESHOLD 0.7
-#define MOD 1000000007
 
-typedef struct HashNode{
-    char *key;
-    void *value;
-    struct HashNode *next;
-}HashNode;
+#define GROUP_WIDTH 16 // Number of control bytes probed together with one SSE2 compare
+#define CTRL_EMPTY ((signed char)-128) // Slot has never been used
+#define CTRL_DELETED ((signed char)-2) // Tombstone left behind by deleteKey
+#define IS_FULL(ctrl) ((ctrl) >= 0) // Full slots store the low 7 bits of the key's hash
+
+#define MIGRATION_STEP_SLOTS (4*GROUP_WIDTH) // Old slots moved by every write while the map is rehashing
+
+// A slot is the key pointer followed by the value stored inline
+#define SLOT_AT(table, index) ((table)->slots + (size_t)(index)*(table)->slotSize)
+#define SLOT_KEY(table, index) (*(char **)SLOT_AT(table, index))
+#define SLOT_VALUE(table, index) ((void *)(SLOT_AT(table, index) + sizeof(char *)))
+#define KEY_OF_VALUE(value) (*(char **)((char *)(value) - sizeof(char *))) // Key stored in front of a value returned by get
 
 typedef struct{
-    HashNode **table; // We use double pointers because HashNodes are also pointers to other HashNodes (because of next)
-    int capacity;
-    int size;
+    signed char *ctrl; // One control byte per slot: CTRL_EMPTY, CTRL_DELETED or 7 bits of the hash
+    char *slots; // Keys and inline values, parallel to ctrl
+    size_t slotSize; // Key pointer plus value, padded to pointer alignment
+    int capacity; // Always a power of two and a multiple of GROUP_WIDTH
+    int size; // Number of full slots
+    int tombstones; // Number of CTRL_DELETED slots
+}HashTable;
+
+typedef struct{
+    HashTable table; // Table that receives new keys
+    HashTable old; // Table being drained by an incremental rehash, old.ctrl is NULL when there is none
+    int migrateIndex; // Next slot of old that will be moved into table
+    size_t valueSize; // Size of the value stored in every slot
+    uint64_t seed; // Hash seed, see processHashSeed
+    int size; // Number of keys in both tables
+    long long migrationNanos; // Total time spent moving keys between tables
+    long long maxMigrationStepNanos; // Longest single migration step, the latency a write can pay for rehashing
 }HashMap;
 
-void initializeMap(HashMap *map, int capacity);
-unsigned int hash(HashMap *map, const char *key);
+void initializeMap(HashMap *map, int capacity, size_t valueSize);
+uint64_t hash(HashMap *map, const char *key);
 void rehash(HashMap *map);
 int contains(HashMap *map, const char *key);
-void insert(HashMap *map, const char *key, void *value, size_t valueSize);
+int probeLength(HashMap *map, const char *key);
+void insert(HashMap *map, const char *key, const void *value);
 void* get(HashMap *map, const char *key);
+void* getSlice(HashMap *map, const char *key, size_t length);
+void* findOrInsert(HashMap *map, const char *key, int *inserted);
+void* findOrInsertSlice(HashMap *map, const char *key, size_t length, int *inserted);
 void deleteKey(HashMap *map, const char *key);
-void update(HashMap *map, const char *key, void *value, size_t valueSize);
+void update(HashMap *map, const char *key, const void *value);
+void freeMap(HashMap *map, void (*freeValue)(void *value));
 
 
 #endif
-
@@ -0,0 +1,17 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stddef.h>
+
+typedef struct{
+    const char *data; // Mapping of the whole file, NULL for an empty file
+    size_t size; // Size of the file
+    size_t offset; // Start of the next line
+}MappedInput;
+
+int openMappedInput(MappedInput *input, const char *path);
+int nextMappedLine(MappedInput *input, const char **line, size_t *length);
+void closeMappedInput(MappedInput *input);
+
+
+#endif
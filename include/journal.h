@@ -0,0 +1,93 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+#include <time.h>
+#include "commands.h"
+#include "arena.h"
+
+/*
+ * The journal is an append-only log of the changes that commands made to an inventory. Commands that
+ * change nothing are not logged. A journal file is a JournalHeader followed by records. Every record is
+ * a JournalFrame and then its payload. The payload is a type and unsigned integers, each written as a
+ * base 128 varint. Records name symbols by ids that a NAME record defined earlier in the same file, so
+ * the file does not depend on the symbols of the process that wrote it.
+ *
+ *   NAME      id, length, bytes of the name
+ *   COUNTERS  trophy count, ingredient count, then id and amount for every trophy removed and
+ *             every ingredient added
+ *   BREW      potion, times
+ *   RECIPE    potion, pair count, then id and count for every pair in formula order
+ *   SIGN      monster, sign
+ *   EFFECTIVE monster, potion
+ *   ENCOUNTER monster
+ *   LOAD      generation, length, bytes of the path of a checkpoint snapshot that replaces the whole
+ *             inventory
+ *
+ * Records collect in memory and are written and synced as one group once JOURNAL_GROUP_BYTES are
+ * pending or the oldest pending record is JOURNAL_GROUP_MILLISECONDS old, also while the input is quiet:
+ * the readers of stdin, the pipeline and the server commit when they would otherwise wait with records
+ * pending. A crash loses at most that group. Replay stops at the first record that is cut short or fails its check, and the file is cut there.
+ *
+ * A checkpoint writes the inventory to a snapshot of its own, JOURNAL.GENERATION.snap next to the journal,
+ * before a new journal file that starts with its LOAD record replaces the old one. The snapshot of the
+ * previous checkpoint is removed after that. Snapshots of Save and Load can be overwritten at any time,
+ * so the journal never names them, and a crash at any step leaves a journal whose snapshot matches it.
+ */
+#define JOURNAL_MAGIC "WTJRNL\r\n" // 8 bytes
+#define JOURNAL_VERSION 2
+#define JOURNAL_GROUP_BYTES (64*1024) // Pending bytes that force a group commit
+#define JOURNAL_GROUP_MILLISECONDS 10 // Age of the oldest pending record that forces a group commit
+#define JOURNAL_CHECK_SEED 0x6a6f75726e616cULL // Seed of the check of every record
+
+typedef enum{
+    JOURNAL_NAME = 1,
+    JOURNAL_COUNTERS,
+    JOURNAL_BREW,
+    JOURNAL_RECIPE,
+    JOURNAL_SIGN,
+    JOURNAL_EFFECTIVE,
+    JOURNAL_ENCOUNTER,
+    JOURNAL_LOAD
+}JournalType;
+
+typedef struct{
+    char magic[8];
+    uint32_t version;
+    uint32_t unused;
+}JournalHeader;
+
+typedef struct{
+    uint32_t size; // Bytes of the payload
+    uint32_t check; // Low 32 bits of the hash of the payload
+}JournalFrame;
+
+struct Journal{
+    int fd;
+    char *path; // Path of the journal, a checkpoint replaces the file
+    char *pending; // Records not written yet
+    size_t used;
+    size_t capacity;
+    size_t recordStart; // Offset in pending of the record being built
+    struct timespec pendingSince; // When the oldest pending record was added
+    unsigned char *named; // Nonzero for every symbol a NAME record of the file defines, indexed by symbol
+    int namedCapacity;
+    uint64_t generation; // Generation of the last checkpoint, 0 before the first one
+    char *snapshot; // Absolute path of the snapshot of the last checkpoint, NULL before the first one
+};
+
+int openJournal(Journal *journal, const char *path, Inventory *inventory, Arena *scratch);
+void journalCounters(Journal *journal, const PairArray *trophies, const PairArray *ingredients);
+void journalStagedCounters(Journal *journal, const StagedPairs *trophies, const StagedPairs *ingredients);
+void journalBrew(Journal *journal, Symbol potion, int64_t times);
+void journalRecipe(Journal *journal, Symbol potion, const PairArray *ingredients);
+void journalSign(Journal *journal, Symbol monster, Symbol sign);
+void journalEffective(Journal *journal, Symbol monster, Symbol potion);
+void journalEncounter(Journal *journal, Symbol monster);
+int checkpointJournal(Journal *journal, Inventory *inventory);
+void commitJournal(Journal *journal);
+void commitJournalIfDue(Journal *journal);
+void closeJournal(Journal *journal);
+
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef KEYWORDS_H
+#define KEYWORDS_H
+
+/*
+ * Every word the grammar knows. A row is X(id, text, first character, last character), the two
+ * characters feed KEYWORD_HASH so it can be evaluated in a case label.
+ */
+#define KEYWORDS(X) \
+    X(KW_GERALT, "Geralt", 'G', 't') \
+    X(KW_LOOTS, "loots", 'l', 's') \
+    X(KW_TRADES, "trades", 't', 's') \
+    X(KW_BREWS, "brews", 'b', 's') \
+    X(KW_LEARNS, "learns", 'l', 's') \
+    X(KW_ENCOUNTERS, "encounters", 'e', 's') \
+    X(KW_TOTAL, "Total", 'T', 'l') \
+    X(KW_INGREDIENT, "ingredient", 'i', 't') \
+    X(KW_POTION, "potion", 'p', 'n') \
+    X(KW_TROPHY, "trophy", 't', 'y') \
+    X(KW_WHAT, "What", 'W', 't') \
+    X(KW_IS, "is", 'i', 's') \
+    X(KW_IN, "in", 'i', 'n') \
+    X(KW_EFFECTIVE, "effective", 'e', 'e') \
+    X(KW_AGAINST, "against", 'a', 't') \
+    X(KW_A, "a", 'a', 'a') \
+    X(KW_SIGN, "sign", 's', 'n') \
+    X(KW_CONSISTS, "consists", 'c', 's') \
+    X(KW_OF, "of", 'o', 'f') \
+    X(KW_FOR, "for", 'f', 'r') \
+    X(KW_EXIT, "Exit", 'E', 't') \
+    X(KW_HOW, "How", 'H', 'w') \
+    X(KW_MANY, "many", 'm', 'y') \
+    X(KW_CAN, "can", 'c', 'n') \
+    X(KW_BE, "be", 'b', 'e') \
+    X(KW_BREWED, "brewed", 'b', 'd') \
+    X(KW_SAVE, "Save", 'S', 'e') \
+    X(KW_LOAD, "Load", 'L', 'd') \
+    X(KW_TO, "to", 't', 'o') \
+    X(KW_FROM, "from", 'f', 'm')
+
+/*
+ * Perfect hash of the keywords above. lookupKeyword switches on it, so two keywords with the same hash
+ * are a duplicate case label and the build fails, change the constants until it compiles again.
+ */
+#define KEYWORD_TABLE_SIZE 64
+#define KEYWORD_HASH(length, first, last) ((((length)*2 + (first)*31 + (last)*18)) & (KEYWORD_TABLE_SIZE-1))
+
+#define KEYWORD_ENUM(id, text, first, last) id,
+
+typedef enum{
+    KW_NONE = 0, // Not a keyword
+    KEYWORDS(KEYWORD_ENUM)
+    KW_COUNT
+}Keyword;
+
+Keyword lookupKeyword(const char *text, int length);
+
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <stddef.h>
+#include "keywords.h"
+
+typedef enum{
+    TOKEN_WORD, // Any run of characters that is not one of the others
+    TOKEN_NUMBER, // Positive integer without leading zeros that fits in an int
+    TOKEN_COMMA, // ","
+    TOKEN_QMARK // "?", also when it is attached to a word
+}TokenType;
+
+typedef struct{
+    TokenType type;
+    int offset; // Position of the first character in the line
+    int length; // Number of characters
+    int value; // Value of a TOKEN_NUMBER
+    Keyword keyword; // Keyword of a TOKEN_WORD, KW_NONE for anything else
+}Token;
+
+int lexLine(const char *line, size_t length, Token *tokens);
+
+
+#endif
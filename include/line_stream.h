@@ -0,0 +1,52 @@
+#ifndef LINE_STREAM_H
+#define LINE_STREAM_H
+
+#include <stddef.h>
+#include "commands.h"
+#include "structures.h"
+
+#define STREAM_THRESHOLD (64*1024) // Lines up to this length are executed whole, longer loot and trade lines are streamed
+#define LONG_LINE_LIMIT (1024*1024) // Longest line that is collected whole and longest token of a streamed line, longer lines are INVALID
+
+typedef enum{
+    LINE_WHOLE, // Collected until the end of the line, then executed like any other line
+    LINE_LONG, // Too long to be collected, but not a loot or trade, collected whole anyway
+    LINE_STREAMED, // Loot or trade whose pairs are folded into the staged pairs as they arrive
+    LINE_SKIPPED // Known to be INVALID, the rest of the line is dropped
+}LineMode;
+
+typedef enum{
+    EXPECT_COUNT, // Number that starts a pair
+    EXPECT_NAME, // Name that ends a pair
+    AFTER_PAIR, // Comma, the end of the line or the "trophy" after the trophies of a trade
+    EXPECT_FOR // "for" after "trophy"
+}PairState;
+
+typedef struct{
+    char *data; // Bytes of the current line that are not consumed yet
+    size_t length;
+    size_t capacity;
+    size_t searched; // Bytes of data already known to contain no place to cut
+    int open; // Some bytes of the current line were fed
+
+    LineMode mode;
+    Keyword command; // KW_LOOTS or KW_TRADES while streaming
+    PairState state;
+    int forSeen; // A trade is past "trophy for", pairs are ingredients
+    int pendingCount; // Count of the pair whose name is expected
+
+    StagedPairs ingredients; // Ingredients of the line, folded per ingredient
+    StagedPairs trophies; // Trophies of a trade, folded per trophy
+
+    Token *tokens; // Tokens of the part being consumed
+    size_t tokenCapacity;
+}LineAssembler;
+
+void initializeAssembler(LineAssembler *assembler);
+int assemblerIdle(const LineAssembler *assembler);
+void feedLine(LineAssembler *assembler, const char *piece, size_t length);
+int endLine(LineAssembler *assembler, Inventory *inventory, const char **line, size_t *length);
+void freeAssembler(LineAssembler *assembler);
+
+
+#endif
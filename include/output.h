@@ -0,0 +1,20 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stddef.h>
+
+#define OUTPUT_BUFFER_SIZE (1 << 20) // Bytes collected before a write to stdout
+
+typedef struct{
+    char *data;
+    size_t length; // Bytes of answers in data
+    size_t capacity;
+}OutputBuffer;
+
+void outRedirect(OutputBuffer *redirect);
+void outWrite(const char *data, size_t length);
+void outPrintf(const char *format, ...);
+void outFlush(void);
+
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stddef.h>
+#include <pthread.h>
+#include "ring.h"
+#include "commands.h"
+#include "line_stream.h"
+#include "input.h"
+#include "arena.h"
+
+/*
+ * The pipeline splits a run into three stages. A reader thread cuts the input into batches of lines,
+ * parser threads lex and validate the lines of a batch into commands, and the calling thread executes the
+ * commands. Parsing only looks at the line, so any number of batches can be parsed at once, execution
+ * stays on one thread and in input order, and the output is the same as without the pipeline.
+ *
+ * Batch k goes to parser k % parserCount and comes back from it in order, so every queue has a single
+ * producer and a single consumer and the executor restores the input order by taking the parsers in turn.
+ * Lines longer than STREAM_THRESHOLD are not parsed ahead, their pieces go through the executor's assembler.
+ */
+#define PIPELINE_MAX_PARSERS 64
+#define PIPELINE_BATCH_LINES 1024 // Lines after which a batch is handed on
+#define PIPELINE_BATCH_BYTES STREAM_THRESHOLD // Bytes of a mapped input after which a batch is handed on
+#define PIPELINE_QUEUE_BATCHES 4 // Batches each queue between two stages holds
+#define PIPELINE_SPINS 64 // Empty or full polls of a queue before the thread yields
+
+typedef enum{
+    RECORD_COMMAND, // Valid command, ready to execute
+    RECORD_INVALID,
+    RECORD_EXIT,
+    RECORD_LINE, // Line not parsed yet
+    RECORD_PIECE, // Piece of a long line
+    RECORD_LAST_PIECE // Last piece of a long line
+}RecordKind;
+
+typedef struct{
+    RecordKind kind;
+    const char *line; // View of the line or piece, into the mapping or the text of the batch
+    size_t length;
+    int tokenStart; // First token of a command in the tokens of the batch
+    Command command;
+}LineRecord;
+
+typedef struct{
+    LineRecord *records;
+    int count;
+    int capacity;
+    Token *tokens; // Tokens of every command of the batch
+    int tokenCount;
+    int tokenCapacity;
+    char *text; // Bytes of the lines read from stdin, unused for a mapped input
+}Batch;
+
+typedef struct Pipeline Pipeline;
+
+typedef struct{
+    Pipeline *pipeline;
+    Ring batches; // Batches from the reader
+    Ring parsed; // Batches for the executor
+    Token *tokens; // Tokens of the line being parsed
+    size_t tokenCapacity;
+    int symbolReader; // Reader slot for the symbols of name arguments
+    pthread_t thread;
+}ParserStage;
+
+struct Pipeline{
+    MappedInput *mapped; // Input of the reader, NULL for stdin
+    Batch *pool; // Every batch, owned by the pipeline
+    int poolSize;
+    Ring freeBatches; // Batches the executor is done with, back to the reader
+    ParserStage *parsers;
+    int parserCount;
+    atomic_int stopping; // Set once Exit is executed, every stage ends early
+    int wake[2]; // Written on stop, wakes a reader that waits for stdin
+    pthread_t reader;
+};
+
+typedef int (*LineHandler)(const char *line, size_t length);
+
+int runPipeline(MappedInput *mapped, int parserCount, Inventory *inventory, Arena *scratch, LineAssembler *assembler, LineHandler handleLine);
+
+
+#endif
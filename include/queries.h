@@ -1,12 +1,16 @@
 #include "hashmap.h"
+#include "typed_maps.h"
+#include "symbols.h"
 
 
 
-void specificIngredients(HashMap *ingredients, char *ingredient);
-void specificPotion(HashMap *potions, char *potion);
-void specificTrophies(HashMap *trophies, char *trophy);
-void allIngredients(HashMap *ingredients);
-void allPotions(HashMap *potions);
-void allTrophies(HashMap* trophies);
-void potionSignEffectiveness(HashMap *monsters, char *monster);
-void potionFormula(HashMap *potions,char *potion);
+void specificIngredients(CounterTable *ingredients, Symbol ingredient);
+void specificPotion(PotionTable *potions, Symbol potion);
+void specificTrophies(CounterTable *trophies, Symbol trophy);
+void allIngredients(CounterTable *ingredients);
+void allPotions(PotionTable *potions);
+void allTrophies(CounterTable* trophies);
+void potionSignEffectiveness(BestiaryTable *monsters, Symbol monster, const char *name);
+void potionFormula(PotionTable *potions, Symbol potion, const char *name);
+void specificBrewable(PotionTable *potions, Symbol potion, const char *name);
+void allBrewable(PotionTable *potions);
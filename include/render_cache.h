@@ -0,0 +1,22 @@
+#ifndef RENDER_CACHE_H
+#define RENDER_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct{
+    char *text; // Rendered output of the last query, not NUL terminated
+    size_t length; // Bytes used in text
+    size_t capacity; // Capacity of text
+    uint64_t version; // Version of the owner when text was rendered
+    int valid; // 0 until the first render
+}RenderCache;
+
+int renderCacheHit(RenderCache *cache, uint64_t version);
+void renderAppend(RenderCache *cache, const char *format, ...);
+void renderCommit(RenderCache *cache, uint64_t version);
+void freeRenderCache(RenderCache *cache);
+void renderCacheStats(long long *hitCount, long long *missCount);
+
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef RING_H
+#define RING_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+#define RING_LINE 64 // Size of a cache line, head and tail live on different lines
+
+/*
+ * A bounded queue of pointers for exactly one producer thread and one consumer thread. Neither side ever
+ * takes a lock: the producer only writes tail, the consumer only writes head, and each reads the other's
+ * index with acquire ordering, so a slot is always written before it is seen.
+ */
+typedef struct{
+    void **slots;
+    size_t mask; // Capacity - 1, the capacity is a power of two
+    _Alignas(RING_LINE) atomic_size_t head; // Next slot to pop, written by the consumer
+    _Alignas(RING_LINE) atomic_size_t tail; // Next slot to push, written by the producer
+}Ring;
+
+void initializeRing(Ring *ring, size_t capacity);
+int ringPush(Ring *ring, void *item);
+int ringPop(Ring *ring, void **item);
+void freeRing(Ring *ring);
+
+
+#endif
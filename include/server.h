@@ -0,0 +1,26 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "commands.h"
+#include "line_stream.h"
+#include "output.h"
+
+#define SERVER_MAX_EVENTS 64 // Events taken from epoll at once
+#define CLIENT_OUTPUT_LIMIT (1 << 20) // Unsent answers after which a client is not read until it catches up
+
+typedef struct{
+    int fd;
+    LineAssembler assembler; // Line that is not complete yet
+    OutputBuffer output; // Answers not sent yet
+    size_t sent; // Bytes of output already sent
+    int closing; // Exit or the end of the input was read, the client is closed once its answers are sent
+    unsigned int events; // Events the client is registered for
+}Client;
+
+typedef int (*ChunkHandler)(LineAssembler *assembler, const char *chunk, size_t count);
+typedef int (*InputEndHandler)(LineAssembler *assembler);
+
+int runServer(const char *path, Inventory *inventory, ChunkHandler executeChunk, InputEndHandler finishInput);
+
+
+#endif
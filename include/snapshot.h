@@ -0,0 +1,65 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdint.h>
+#include "commands.h"
+#include "arena.h"
+
+/*
+ * A snapshot holds the four tables of an inventory. Every record starts at a multiple of 8 bytes, so the
+ * records can be read in place from a mapping. Names are stored once, records refer to them by their
+ * index in the file, never by an address or by a symbol of the process that wrote them. Integers are
+ * in the byte order of the writer, a snapshot from a machine of the other order fails the magic check.
+ *
+ *   SnapshotHeader
+ *   uint64_t nameEnds[symbolCount]          End of every name in the name bytes
+ *   char names[nameBytes]                   Names one after another, not NUL terminated
+ *   SnapshotCounter ingredients[ingredientCount]
+ *   SnapshotCounter trophies[trophyCount]
+ *   potionCount times:  SnapshotPotion, SnapshotPair pairs[pairCount]
+ *   monsterCount times: SnapshotMonster, uint32_t potions[potionCount], uint32_t signs[signCount],
+ *                       uint32_t merged[potionCount+signCount]
+ */
+#define SNAPSHOT_MAGIC "WTSNAP\r\n" // 8 bytes, the line break catches text mode transfers
+#define SNAPSHOT_VERSION 2 // Bumped whenever the layout changes, older versions are rejected
+
+typedef struct{
+    char magic[8];
+    uint32_t version;
+    uint32_t symbolCount; // Names in the file
+    uint64_t nameBytes;
+    uint32_t ingredientCount;
+    uint32_t trophyCount;
+    uint32_t potionCount;
+    uint32_t monsterCount;
+}SnapshotHeader;
+
+typedef struct{
+    uint32_t symbol; // Index of the name
+    uint32_t unused;
+    int64_t amount;
+}SnapshotCounter;
+
+typedef struct{
+    uint32_t symbol;
+    uint32_t pairCount; // Pairs of the recipe in formula order, 0 if the recipe is not known
+    int64_t potionCount; // Brewed amount
+}SnapshotPotion;
+
+typedef struct{
+    uint32_t symbol;
+    int32_t count;
+}SnapshotPair;
+
+typedef struct{
+    uint32_t symbol;
+    uint32_t potionCount; // Effective potions in the order they were learned
+    uint32_t signCount; // Effective signs in the order they were learned
+    uint32_t unused;
+}SnapshotMonster;
+
+int saveSnapshot(Inventory *inventory, const char *path);
+int loadSnapshot(Inventory *inventory, const char *path, Arena *scratch);
+
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef SORTED_INDEX_H
+#define SORTED_INDEX_H
+
+#include <stdint.h>
+#include "symbols.h"
+
+typedef struct{
+    Symbol *keys; // keys[0, sorted) are ordered by name, keys[sorted, size) were added since the last query
+    Symbol *scratch; // Merge buffer, as large as keys
+    int size; // Number of symbols in the index
+    int sorted; // Length of the ordered prefix
+    int capacity; // Capacity of keys and scratch
+    uint8_t *member; // One byte per symbol, 1 when the symbol is in the index
+    int memberCapacity; // Capacity of member
+}SortedIndex;
+
+void initializeIndex(SortedIndex *index);
+void addToIndex(SortedIndex *index, Symbol symbol);
+const Symbol *orderedSymbols(SortedIndex *index, int *count);
+void freeIndex(SortedIndex *index);
+
+
+#endif
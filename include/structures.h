@@ -4,32 +4,74 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "symbols.h"
+#include "render_cache.h"
+#include "symbol_set.h"
 
 typedef struct{
-    char *key;
+    Symbol key;
     int count;
 }Pair;
 
 typedef struct{
-    Pair **array; // array is a pointer to an array of Pair pointers
+    Pair *array; // Pairs stored one after another
     int size; // Number of pairs inside array
     int capacity;  // Current maximum capacity of array
 }PairArray;
 
 typedef struct{
-    int potionCount;
-    PairArray *recipe;
+    Symbol key;
+    int64_t total; // Sum of every count given for the key
+    int largest; // Largest single count given for the key
+}StagedPair;
+
+typedef struct{
+    int size; // Number of pairs
+    int ingredientCount; // Number of distinct ingredients
+    const StagedPair *ingredients; // The pairs folded per ingredient, stored after the pairs
+    Pair pairs[]; // Ingredients in formula order, stored in the same allocation as the size
+}Recipe;
+
+typedef struct{
+    StagedPair *pairs; // One entry per distinct key, in the order the keys were first seen
+    int size;
+    int capacity;
+    int *slots; // Index in pairs for every symbol id, -1 when the symbol is not staged
+    int slotCapacity;
+}StagedPairs;
+
+typedef struct{
+    int64_t potionCount;
+    const Recipe *recipe; // Never changes once learned, NULL until then
+    uint64_t version; // Bumped when the recipe changes
+    RenderCache rendered; // Last answer to "What is in" for this potion
+    int64_t brewable; // Brews the ingredients allow right now, kept up to date by the brew index
+    int64_t *allowed; // Brews every folded ingredient of the recipe allows on its own, brewable is the smallest
 }Potion;
 
 typedef struct {
-    char **effectivePotions;
+    Symbol *effectivePotions; // In the order they were learned
     int potionCount;
+    int potionCapacity;
+    SymbolSet potionSet; // Membership of effectivePotions
 
-    char **effectiveSigns;
+    Symbol *effectiveSigns;
     int signCount;
+    int signCapacity;
+    SymbolSet signSet;
+
+    Symbol *merged; // Potions and signs together ordered by name, potionCount+signCount entries
+    int mergedCapacity;
+
+    uint64_t version; // Bumped when a sign or potion is learned
+    RenderCache rendered; // Last answer to "What is effective against" for this monster
 }Bestiary;
 
 void resizeArray(PairArray *pairArray);
+void initializeStagedPairs(StagedPairs *staged);
+void stagePair(StagedPairs *staged, Symbol key, int count);
+void clearStagedPairs(StagedPairs *staged);
+void freeStagedPairs(StagedPairs *staged);
 
 
 #endif
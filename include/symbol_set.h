@@ -0,0 +1,19 @@
+#ifndef SYMBOL_SET_H
+#define SYMBOL_SET_H
+
+#include "symbols.h"
+
+#define SYMBOL_SET_INITIAL_CAPACITY 8 // Slots of a set after its first insert, always a power of two
+
+typedef struct{
+    Symbol *slots; // Open addressing with linear probing, NO_SYMBOL marks an empty slot
+    int capacity; // 0 until the first insert, an all zero set is a valid empty set
+    int size; // Number of symbols in the set, kept at most half of capacity
+}SymbolSet;
+
+int addToSymbolSet(SymbolSet *set, Symbol symbol);
+int symbolSetContains(const SymbolSet *set, Symbol symbol);
+void freeSymbolSet(SymbolSet *set);
+
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef SYMBOLS_H
+#define SYMBOLS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint32_t Symbol; // Dense id of an interned name, ids start from 0
+
+#define NO_SYMBOL UINT32_MAX
+
+Symbol internSymbol(const char *name);
+Symbol internSymbolSlice(const char *name, size_t length);
+int registerSymbolReader(void);
+Symbol findSymbolSlice(int reader, const char *name, size_t length);
+Symbol lookupSymbolSlice(const char *name, size_t length);
+const char *symbolName(Symbol symbol);
+int symbolCount(void);
+void symbolRehashStats(long long *totalNanos, long long *longestStepNanos);
+int compareSymbols(const void *symbol_ptr_1, const void *symbol_ptr_2);
+void freeSymbols(void);
+
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef TYPED_MAPS_H
+#define TYPED_MAPS_H
+
+#include <stdint.h>
+#include "hashmap.h"
+#include "symbols.h"
+#include "structures.h"
+#include "sorted_index.h"
+
+/*
+ * DECLARE_TYPED_MAP generates a map type whose values of type ValueType are stored inline in the
+ * slots of a HashMap, together with typed wrappers around the HashMap functions. DEFINE_TYPED_MAP
+ * generates the matching definitions, freeValue releases whatever memory a value owns.
+ */
+#define DECLARE_TYPED_MAP(MapType, Name, ValueType) \
+    typedef struct{ \
+        HashMap base; \
+    }MapType; \
+    void initializeMap##Name(MapType *map, int capacity); \
+    int contains##Name(MapType *map, const char *key); \
+    ValueType *get##Name(MapType *map, const char *key); \
+    ValueType *getSlice##Name(MapType *map, const char *key, size_t length); \
+    ValueType *findOrInsert##Name(MapType *map, const char *key, int *inserted); \
+    ValueType *findOrInsertSlice##Name(MapType *map, const char *key, size_t length, int *inserted); \
+    void insert##Name(MapType *map, const char *key, ValueType value); \
+    void update##Name(MapType *map, const char *key, ValueType value); \
+    void freeHashMap##Name(MapType *map);
+
+#define DEFINE_TYPED_MAP(MapType, Name, ValueType, freeValue) \
+    void initializeMap##Name(MapType *map, int capacity){ \
+        initializeMap(&map->base, capacity, sizeof(ValueType)); \
+    } \
+    int contains##Name(MapType *map, const char *key){ \
+        return contains(&map->base, key); \
+    } \
+    ValueType *get##Name(MapType *map, const char *key){ \
+        return (ValueType *)get(&map->base, key); \
+    } \
+    ValueType *getSlice##Name(MapType *map, const char *key, size_t length){ \
+        return (ValueType *)getSlice(&map->base, key, length); \
+    } \
+    ValueType *findOrInsert##Name(MapType *map, const char *key, int *inserted){ \
+        return (ValueType *)findOrInsert(&map->base, key, inserted); \
+    } \
+    ValueType *findOrInsertSlice##Name(MapType *map, const char *key, size_t length, int *inserted){ \
+        return (ValueType *)findOrInsertSlice(&map->base, key, length, inserted); \
+    } \
+    void insert##Name(MapType *map, const char *key, ValueType value){ \
+        insert(&map->base, key, &value); \
+    } \
+    void update##Name(MapType *map, const char *key, ValueType value){ \
+        ValueType *slot = get##Name(map, key); \
+        if (slot) \
+            *slot = value; \
+    } \
+    static void freeValueOf##Name(void *value){ \
+        freeValue((ValueType *)value); \
+    } \
+    void freeHashMap##Name(MapType *map){ \
+        if (!map) \
+            return; \
+        freeMap(&map->base, freeValueOf##Name); \
+        free(map); \
+    }
+
+/*
+ * DECLARE_SYMBOL_TABLE generates a dense array of ValueType indexed by Symbol. Entries that were
+ * never written are zero. entry##Name grows the array to cover a symbol, find##Name returns NULL
+ * for symbols the table has not grown to yet. Every symbol passed to entry##Name is also added to
+ * index, which lists the symbols of the table ordered by name. total and nonzero are running
+ * aggregates over the amounts of the table, kept up to date by addToCounter and addToPotion, which
+ * also bump version. rendered caches the last Total answer of the table for that version. When changed
+ * is set, addToCounter and removeIngredients call it with observer after they change an entry.
+ */
+#define DECLARE_SYMBOL_TABLE(TableType, Name, ValueType) \
+    typedef struct{ \
+        ValueType *entries; \
+        int capacity; \
+        SortedIndex index; \
+        int64_t total; \
+        int nonzero; \
+        uint64_t version; \
+        RenderCache rendered; \
+        void (*changed)(void *observer, Symbol symbol); \
+        void *observer; \
+    }TableType; \
+    void initializeTable##Name(TableType *table); \
+    ValueType *entry##Name(TableType *table, Symbol symbol); \
+    ValueType *find##Name(TableType *table, Symbol symbol); \
+    void freeTable##Name(TableType *table);
+
+#define DEFINE_SYMBOL_TABLE(TableType, Name, ValueType, freeValue) \
+    void initializeTable##Name(TableType *table){ \
+        table->entries = NULL; \
+        table->capacity = 0; \
+        initializeIndex(&table->index); \
+        table->total = 0; \
+        table->nonzero = 0; \
+        table->version = 0; \
+        memset(&table->rendered, 0, sizeof(RenderCache)); \
+        table->changed = NULL; \
+        table->observer = NULL; \
+    } \
+    ValueType *entry##Name(TableType *table, Symbol symbol){ \
+        if ((int)symbol >= table->capacity){ \
+            int newCapacity = table->capacity ? table->capacity : 16; \
+            while (newCapacity <= (int)symbol) \
+                newCapacity *= 2; \
+            ValueType *newEntries = realloc(table->entries, newCapacity*sizeof(ValueType)); \
+            if (!newEntries){ \
+                printf("Memory reallocation failed!"); \
+                exit(EXIT_FAILURE); \
+            } \
+            memset(newEntries + table->capacity, 0, (newCapacity - table->capacity)*sizeof(ValueType)); \
+            table->entries = newEntries; \
+            table->capacity = newCapacity; \
+        } \
+        addToIndex(&table->index, symbol); \
+        return &table->entries[symbol]; \
+    } \
+    ValueType *find##Name(TableType *table, Symbol symbol){ \
+        if (symbol >= (Symbol)table->capacity) /* Also NO_SYMBOL, a name that was never interned */ \
+            return NULL; \
+        return &table->entries[symbol]; \
+    } \
+    void freeTable##Name(TableType *table){ \
+        if (!table) \
+            return; \
+        for (int i = 0; i < table->capacity; i++) \
+            freeValue(&table->entries[i]); \
+        free(table->entries); \
+        freeIndex(&table->index); \
+        freeRenderCache(&table->rendered); \
+        free(table); \
+    }
+
+DECLARE_TYPED_MAP(SymbolMap, Symbol, Symbol) // Interned name to its symbol
+
+DECLARE_SYMBOL_TABLE(CounterTable, Counter, int64_t) // Ingredient and trophy counts
+int64_t addToCounter(CounterTable *counters, Symbol key, int64_t delta);
+void removeIngredients(CounterTable *counters, const StagedPair *ingredients, int size, int64_t times);
+DECLARE_SYMBOL_TABLE(PotionTable, Potion, Potion) // Potion recipes and brewed amounts
+int64_t addToPotion(PotionTable *potions, Symbol key, int64_t delta);
+DECLARE_SYMBOL_TABLE(BestiaryTable, Monster, Bestiary) // Effective signs and potions per monster
+
+
+#endif
@@ -1,277 +1,388 @@
 #include "hashmap.h"
 #include "structures.h"
+#include "typed_maps.h"
+#include "symbols.h"
 #include "helper_methods.h"
+#include "output.h"
+#include "brew_index.h"
 
 /**
  * @brief Loots the ingredients from the loot array and updates the hashmap
- * @param ingredients The hashmap containing the ingredients
+ * @param ingredients The table containing the ingredients
  * @param lootArray The array of pairs containing the ingredients and their counts
  */
-void loot(HashMap *ingredients, PairArray *lootArray){
+void loot(CounterTable *ingredients, PairArray *lootArray){
     for (int i = 0; i < lootArray->size; i++){
-        char *key = lootArray->array[i]->key; // Name of the current loot
-        int val = lootArray->array[i]->count; // Count of the current loot
+        Symbol key = lootArray->array[i].key; // Name of the current loot
+        int val = lootArray->array[i].count; // Count of the current loot
 
-        if (contains(ingredients, key)){ // Checks if the ingredient already exists
-            int pre = *(int*)get(ingredients, key); // Gets the previous amount of the ingredient
-            int newAmount = pre + val;
-            update(ingredients, key, &newAmount, sizeof(newAmount)); // Update the amount of the ingredient
-        }
-        else{  // If it is the first we see key, insert it to hashmap
-            insert(ingredients, key, &val, sizeof(int)); // If the ingredient is new, insert it to the hashmap
-        }
+        addToCounter(ingredients, key, val); // Unseen ingredients start from 0
     }
-    printf("Alchemy ingredients obtained\n");
+    outPrintf("Alchemy ingredients obtained\n");
 }
 
 /**
  * @brief Trades trophies for ingredients
- * @param ingredients The hashmap containing the ingredients
- * @param trophies The hashmap containing the trophies
+ * @param ingredients The table containing the ingredients
+ * @param trophies The table containing the trophies
  * @param requiredIngredients The array of pairs containing the ingredients and their counts
  * @param requiredTrophies The array of pairs containing the trophies and their counts 
+ * @return 1 if the trade was made, 0 if there were not enough trophies
  */
-void trade(HashMap *ingredients, HashMap *trophies, PairArray *requiredIngredients, PairArray *requiredTrophies){
+int trade(CounterTable *ingredients, CounterTable *trophies, PairArray *requiredIngredients, PairArray *requiredTrophies){
     int len_trophies = requiredTrophies->size; // Number of trophies
     int len_ing = requiredIngredients->size; // Number of ingredients
 
     for (int i = 0; i < len_trophies; i++){
-        Pair *currentTrophy = requiredTrophies->array[i]; // Gets the current trophy
+        Pair *currentTrophy = &requiredTrophies->array[i]; // Gets the current trophy
 
-        if(contains(trophies, currentTrophy->key)){ // Check if the corresponding trophy exists
-            int val = *(int *)get(trophies, currentTrophy->key);
-            if (val < currentTrophy->count){ // Checks if there exist sufficient amount
-                printf("Not enough trophies\n"); 
-                return;
-            }
-        }
-        else{ //If there is no such trophy
-            printf("Not enough trophies\n");
-            return;
+        int64_t *val = findCounter(trophies, currentTrophy->key);
+        if (!val || *val < currentTrophy->count){ // Checks if the trophy exists in sufficient amount
+            outPrintf("Not enough trophies\n");
+            return 0;
         }
     }
 
     // If we are here, then trophies have valid names and quantities, so we can reduce the quantities safely
     for (int i = 0; i < len_trophies; i++){
-        Pair *currentTrophy = requiredTrophies->array[i];  // Gets the current trophy
+        Pair *currentTrophy = &requiredTrophies->array[i];  // Gets the current trophy
 
-        int val = *(int *)get(trophies, currentTrophy->key);
-        int newVal = val - currentTrophy->count; // Update the amount
-        update(trophies, currentTrophy->key, &newVal, sizeof(newVal)); // Update trophies hashmap
+        addToCounter(trophies, currentTrophy->key, -currentTrophy->count); // Update trophies table
     }
 
     // Increment the ingredients by specified amount
     for(int i = 0; i < len_ing; i++){
-        Pair *currentIngredient = requiredIngredients->array[i]; // Gets the current ingredient
+        Pair *currentIngredient = &requiredIngredients->array[i]; // Gets the current ingredient
 
-        if(contains(ingredients, currentIngredient->key)){ // Checks if there exist such ingredient
-            int pre = *(int*)get(ingredients, currentIngredient->key);
-            int updated = pre + currentIngredient->count; // Update the amount
-            update(ingredients, currentIngredient->key, &(updated), sizeof(int)); // Update the ingredients hashmap
-        }
-        else{ //If the ingredient is new, insert the ingredient with specified amount
-            insert(ingredients, currentIngredient->key, &(currentIngredient->count), sizeof(int));
+        addToCounter(ingredients, currentIngredient->key, currentIngredient->count); // Update the ingredients table
+    }
+    outPrintf("Trade successful\n");
+    return 1;
+}
+
+/**
+ * @brief Loots ingredients that were folded per ingredient while a long line was streamed, same result as loot
+ * @param ingredients The table containing the ingredients
+ * @param lootTotals The staged ingredients and their total counts
+ */
+void lootStaged(CounterTable *ingredients, const StagedPairs *lootTotals){
+    for (int i = 0; i < lootTotals->size; i++)
+        addToCounter(ingredients, lootTotals->pairs[i].key, lootTotals->pairs[i].total);
+    outPrintf("Alchemy ingredients obtained\n");
+}
+
+/**
+ * @brief Trades trophies that were folded per trophy while a long line was streamed, same result as trade.
+ * trade checks every pair on its own, so the largest count of a trophy is checked and the total is removed
+ * @param ingredients The table containing the ingredients
+ * @param trophies The table containing the trophies
+ * @param ingredientTotals The staged ingredients and their total counts
+ * @param trophyTotals The staged trophies, their total and largest counts
+ * @return 1 if the trade was made, 0 if there were not enough trophies
+ */
+int tradeStaged(CounterTable *ingredients, CounterTable *trophies, const StagedPairs *ingredientTotals, const StagedPairs *trophyTotals){
+    for (int i = 0; i < trophyTotals->size; i++){
+        int64_t *val = findCounter(trophies, trophyTotals->pairs[i].key);
+        if (!val || *val < trophyTotals->pairs[i].largest){ // Checks if the trophy exists in sufficient amount
+            outPrintf("Not enough trophies\n");
+            return 0;
         }
     }
-    printf("Trade successful\n");
+
+    for (int i = 0; i < trophyTotals->size; i++)
+        addToCounter(trophies, trophyTotals->pairs[i].key, -trophyTotals->pairs[i].total);
+
+    for (int i = 0; i < ingredientTotals->size; i++)
+        addToCounter(ingredients, ingredientTotals->pairs[i].key, ingredientTotals->pairs[i].total);
+    outPrintf("Trade successful\n");
+    return 1;
 }
 
 /**
- * @brief Brews a potion using the ingredients from the hashmap
- * @param potions The hashmap containing the potions
- * @param ingredients The hashmap containing the ingredients
+ * @brief Brews a known potion as many times as the ingredients allow, at most a number of times, without
+ * printing anything. The ingredient table must be observed by a brew index that has indexed the recipe
+ * @param potions The table containing the potions
+ * @param ingredients The table containing the ingredients
+ * @param potion The name of the potion, its recipe is known
+ * @param times The most potions to brew
+ * @return The number of potions brewed
+ */
+int64_t brewPotion(PotionTable *potions, CounterTable *ingredients, Symbol potion, int64_t times){
+    Potion *p = findPotion(potions, potion);
+    const Recipe *r = p->recipe;  // Recipe of the potion
+    int64_t brewed = p->brewable < times ? p->brewable : times; // The brew index keeps the bottleneck of the recipe
+
+    if (brewed > 0){
+        removeIngredients(ingredients, r->ingredients, r->ingredientCount, brewed); // Update the ingredients
+        addToPotion(potions, potion, brewed); // Increase the amount of the potion
+    }
+    return brewed;
+}
+
+/**
+ * @brief Brews a potion a number of times using the ingredients from the table. The result and the
+ * output are those of brewing once per time: every brew that the ingredients allow succeeds and every
+ * one after that reports missing ingredients, but the recipe is checked and subtracted only once
+ * @param potions The table containing the potions
+ * @param ingredients The table containing the ingredients
  * @param potion The name of the potion to brew
+ * @param times The number of potions to brew, 1 for "Geralt brews X"
+ * @return The number of potions brewed
  */
-void brew(HashMap *potions, HashMap *ingredients, char *potion){
-    Potion *p = (Potion *)get(potions, potion); // Retrieve the potion struct
+int64_t brew(PotionTable *potions, CounterTable *ingredients, Symbol potion, int times){
+    Potion *p = findPotion(potions, potion); // Retrieve the potion struct
 
-    if (!p){ // Potion is not known
-        printf("No formula for %s\n", potion);
-        return;
+    if (!p || !p->recipe){ // Potion is not known
+        for (int i = 0; i < times; i++)
+            outPrintf("No formula for %s\n", symbolName(potion));
+        return 0;
     }
 
-    PairArray *r = p->recipe;  // Recipe array for the potion
+    int64_t brewed = brewPotion(potions, ingredients, potion, times);
 
-    for (int i = 0; i < r->size; i++){
-        char *currentKey = r->array[i]->key; // Current ingredient key
-        int neededAmount = r->array[i]->count; // Amound needed from current ingredient
+    for (int64_t i = 0; i < brewed; i++)
+        outPrintf("Alchemy item created: %s\n", symbolName(potion));
+    for (int64_t i = brewed; i < times; i++)
+        outPrintf("Not enough ingredients\n");
+    return brewed;
+}
 
-        int *availableAmount = (int*)get(ingredients, currentKey);  // Amount available of current ingredient
-        if (!availableAmount || *availableAmount < neededAmount){ // Checks if there exist sufficient amount
-            printf("Not enough ingredients\n");
-            return;
+/**
+ * @brief Insert a symbol into the merged list of a monster, after the entries with a smaller or equal name
+ * @param b The monster
+ * @param entry The symbol, a sign or potion that was just learned
+ */
+static void insertMerged(Bestiary *b, Symbol entry){
+    int count = b->potionCount + b->signCount; // Entries already in the list
+
+    if (count == b->mergedCapacity){
+        b->mergedCapacity = b->mergedCapacity ? b->mergedCapacity*2 : 4;
+        b->merged = realloc(b->merged, b->mergedCapacity*sizeof(Symbol));
+        if (!b->merged){
+            printf("Memory reallocation failed!");
+            exit(EXIT_FAILURE);
         }
     }
 
-    //
-    for (int i = 0; i < r->size; i++){ // Update the ingredients
-        char *currentKey = r->array[i]->key; // Current ingredient key
-        int neededAmount = r->array[i]->count; // Amound needed from current ingredient
+    const char *name = symbolName(entry);
+    int low = 0, high = count; // Binary search for the first greater name
+    while (low < high){
+        int mid = (low + high) / 2;
+        if (strcmp(symbolName(b->merged[mid]), name) <= 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    memmove(&b->merged[low+1], &b->merged[low], (count-low)*sizeof(Symbol));
+    b->merged[low] = entry;
+}
 
-        int *valPtr = (int*)get(ingredients, currentKey);
-        int newVal = *valPtr - neededAmount; // Update the amount
-        update(ingredients, currentKey, &newVal, sizeof(int)); // Update the ingredients hashmap
+/**
+ * @brief Append a symbol to an effectiveness array, doubling its capacity when it is full
+ * @param array The array
+ * @param count The number of entries, incremented
+ * @param capacity The capacity of the array
+ * @param entry The symbol
+ */
+static void appendEffective(Symbol **array, int *count, int *capacity, Symbol entry){
+    if (*count == *capacity){
+        *capacity = *capacity ? *capacity*2 : 4;
+        *array = realloc(*array, *capacity*sizeof(Symbol));
+        if (!*array){
+            printf("Memory reallocation failed!");
+            exit(EXIT_FAILURE);
+        }
     }
-    p->potionCount += 1; // Increase the amount of the potion
-    printf("Alchemy item created: %s\n", potion);
+    (*array)[(*count)++] = entry;
 }
 
 /**
- * @brief Learns the effectiveness of a sign against a monster
- * @param monsters The hashmap containing the monsters
+ * @brief Add a sign to the effective signs of a monster without printing anything
+ * @param monsters The table containing the monsters
  * @param monster The name of the monster
- * @param sign The name of the sign 
+ * @param sign The name of the sign
+ * @return 1 if the sign was added, 0 if it was already known
  */
-void learnSign(HashMap *monsters, char *monster, char *sign){
+int addEffectiveSign(BestiaryTable *monsters, Symbol monster, Symbol sign){
+    Bestiary *b = entryMonster(monsters, monster); // Retrieves the effective signs and potions to corresponding monster
 
-    if (contains(monsters, monster)){ // Checks if the Gerald knows monster
-        Bestiary *b = (Bestiary*) get(monsters, monster); // Retrieves the effective signs and potions to corresponding monster
+    if (!addToSymbolSet(&b->signSet, sign)) // Checks if Gerald already knows this sign
+        return 0;
+    // If code reaches here, it means the sign is new
 
-        for(int i=0; i < b->signCount; i++){ // Iterate through the effective signs
-            if(strcmp(sign, b->effectiveSigns[i]) == 0){ // Checks if Gerald already knows this sign
-                printf("Already known effectiveness\n");
-                return;
-            }
-        }
-        // If code reaches here, it means the sign is new
+    insertMerged(b, sign); // Before the count changes, the list holds the old entries
+    appendEffective(&b->effectiveSigns, &b->signCount, &b->signCapacity, sign);
+    b->version++; // Cached answers for this monster are stale
+    return 1;
+}
 
-        if (b->signCount == 0)
-            b->effectiveSigns = malloc(sizeof(char *));
-        else
-            b->effectiveSigns = realloc(b->effectiveSigns, sizeof(char*) * (b->signCount + 1)); // Increase the size of array for new sign
-        b->effectiveSigns[b->signCount] = strdup(sign); // Insert the sign
-        b->signCount++; // Increase the size of array
+/**
+ * @brief Add a potion to the effective potions of a monster without printing anything
+ * @param monsters The table containing the monsters
+ * @param monster The name of the monster
+ * @param potion The name of the potion
+ * @return 1 if the potion was added, 0 if it was already known
+ */
+int addEffectivePotion(BestiaryTable *monsters, Symbol monster, Symbol potion){
+    Bestiary *b = entryMonster(monsters, monster);
 
-        printf("Bestiary entry updated: %s\n", monster);
-    }
-    else{ // If the monster is new
+    if (!addToSymbolSet(&b->potionSet, potion)) // Checks if Gerald already knows this potion
+        return 0;
+    // If code reaches here, it means the potion is new
 
-        // Complete necessary allocations
-        Bestiary *newEntry = malloc(sizeof(Bestiary));
-        newEntry->effectiveSigns = malloc(sizeof(char*));
-        newEntry->effectivePotions = NULL;
+    insertMerged(b, potion);
+    appendEffective(&b->effectivePotions, &b->potionCount, &b->potionCapacity, potion);
+    b->version++; // Cached answers for this monster are stale
+    return 1;
+}
 
-        newEntry->effectiveSigns[0] = strdup(sign); // Insert the sign to the array
-        newEntry->signCount = 1; // Increase the size
-        newEntry->potionCount = 0;
+/**
+ * @brief Check if Geralt knows anything about a monster
+ * @param monsters The table containing the monsters
+ * @param monster The name of the monster
+ * @return 1 if a sign or potion is known to be effective against it, 0 otherwise
+ */
+static int monsterKnown(BestiaryTable *monsters, Symbol monster){
+    Bestiary *b = findMonster(monsters, monster);
+    return b && (b->potionCount > 0 || b->signCount > 0); // A known monster has at least one entry
+}
 
-        insert(monsters, monster, newEntry, sizeof(Bestiary)); // Insert the monster to the Monsters Hashmap
-        printf("New bestiary entry added: %s\n", monster);
+/**
+ * @brief Learns the effectiveness of a sign against a monster
+ * @param monsters The table containing the monsters
+ * @param monster The name of the monster
+ * @param sign The name of the sign 
+ * @return 1 if the sign was learned, 0 if it was already known
+ */
+int learnSign(BestiaryTable *monsters, Symbol monster, Symbol sign){
+    int isNew = !monsterKnown(monsters, monster);
+
+    if (!addEffectiveSign(monsters, monster, sign)){
+        outPrintf("Already known effectiveness\n");
+        return 0;
     }
+
+    if (isNew)
+        outPrintf("New bestiary entry added: %s\n", symbolName(monster));
+    else
+        outPrintf("Bestiary entry updated: %s\n", symbolName(monster));
+    return 1;
 }
 
 /**
  * @brief Learns the effectiveness of a potion against a monster
- * @param monsters The hashmap containing the monsters
+ * @param monsters The table containing the monsters
  * @param monster The name of the monster
  * @param potion The name of the potion
+ * @return 1 if the potion was learned, 0 if it was already known
  */
-void learnPotion(HashMap *monsters, char *monster, char *potion){
-    if (contains(monsters, monster)){ //Checks if the Gerald knows monster
-        Bestiary *b = (Bestiary*) get(monsters, monster);
-
-        for(int i=0; i < b->potionCount; i++){ // Iterate through the effective potions
-            if(strcmp(potion, b->effectivePotions[i]) == 0){ // Checks if Gerald already knows this potion
-                printf("Already known effectiveness\n");
-                return;
-            }
-        }
-        // If code reaches here, it means the potion is new
-        if (b->potionCount == 0){
-            b->effectivePotions = malloc(sizeof(char *));
-        }
-        else{
-            b->effectivePotions = realloc(b->effectivePotions, sizeof(char*) * (b->potionCount + 1)); // Increase the size of array for new potion
-        }
-        b->effectivePotions[b->potionCount] = strdup(potion); // Put the potion to the array
-        b->potionCount++; // Increase the size of array
+int learnPotion(BestiaryTable *monsters, Symbol monster, Symbol potion){
+    int isNew = !monsterKnown(monsters, monster);
 
-        printf("Bestiary entry updated: %s\n", monster);
-    }
-    else{
-        // Complete necessary allocations
-        Bestiary *newEntry = malloc(sizeof(Bestiary));
-        newEntry->effectivePotions = malloc(sizeof(char*));
-        newEntry->effectiveSigns = NULL;
-
-        newEntry->effectivePotions[0] = strdup(potion); // Insert the potion to the array
-        newEntry->potionCount = 1; // Increase the size
-        newEntry->signCount = 0;
-
-        insert(monsters, monster, newEntry, sizeof(Bestiary)); // Insert the monster to the Monsters Hashmap
-        printf("New bestiary entry added: %s\n", monster);
+    if (!addEffectivePotion(monsters, monster, potion)){
+        outPrintf("Already known effectiveness\n");
+        return 0;
     }
+
+    if (isNew)
+        outPrintf("New bestiary entry added: %s\n", symbolName(monster));
+    else
+        outPrintf("Bestiary entry updated: %s\n", symbolName(monster));
+    return 1;
 }
 
 /**
- * @brief Learns the recipe of a potion
- * @param potions The hashmap containing the potions
+ * @brief Set the recipe of a potion without printing anything
+ * @param potions The table containing the potions
+ * @param brewIndex The brew index, a new recipe is added to it
  * @param potion The name of the potion
- * @param ingredients The array of pairs containing the ingredients and their counts
+ * @param ingredients The array of pairs containing the ingredients and their counts, it may belong to an
+ * arena, a new recipe is copied into a Recipe before the table keeps it
+ * @return 1 if the recipe was set, 0 if the potion already had one
  */
-void learnPotionRecipe(HashMap *potions, char *potion, PairArray *ingredients){
+int addPotionRecipe(PotionTable *potions, BrewIndex *brewIndex, Symbol potion, const PairArray *ingredients){
+    Potion *p = entryPotion(potions, potion);
 
-    if (contains(potions, potion)){ // If formula is already known
-        printf("Already known formula\n");
-        freePairArray(ingredients);
-        return;
-    }
-
-    Potion *potionWithRecipe = malloc(sizeof(Potion)); // Allocate memory for the potion
-    potionWithRecipe->recipe = ingredients; // Set the recipe
-    potionWithRecipe->potionCount = 0;
+    if (p->recipe) // If formula is already known
+        return 0;
 
-    insert(potions, potion, potionWithRecipe, sizeof(Potion)); // Insert the potion to the potions Hashmap
-    printf("New alchemy formula obtained: %s\n" , potion);
+    p->recipe = createRecipe(ingredients); // The table owns the copy
+    indexRecipe(brewIndex, potion); // Gives every ingredient a counter slot and counts the possible brews
+    p->version++;
+    return 1;
 }
 
-
 /**
- * @brief Geralt encounters a monster and tries to defeat it
- * @param monsters The hashmap containing the monsters
- * @param potions The hashmap containing the potions
- * @param trophies The hashmap containing the trophies
- * @param monster The name of the monster
+ * @brief Learns the recipe of a potion
+ * @param potions The table containing the potions
+ * @param brewIndex The brew index, a new recipe is added to it
+ * @param potion The name of the potion
+ * @param ingredients The array of pairs containing the ingredients and their counts, it belongs to the
+ * arena of the line
+ * @return 1 if the recipe was learned, 0 if it was already known
  */
-void encounter(HashMap *monsters, HashMap *potions, HashMap *trophies, char *monster){
+int learnPotionRecipe(PotionTable *potions, BrewIndex *brewIndex, Symbol potion, const PairArray *ingredients){
+    if (!addPotionRecipe(potions, brewIndex, potion, ingredients)){
+        outPrintf("Already known formula\n");
+        return 0;
+    }
 
-    if(contains(monsters, monster)){ //Checks if Geralt knows the monster
-        Bestiary *b = (Bestiary*) get(monsters, monster);
-        int canDefeat = 0; // Boolean variable to check if Geralt can defeat the monster
+    outPrintf("New alchemy formula obtained: %s\n" , symbolName(potion));
+    return 1;
+}
 
-        for (int i = 0; i < b->potionCount; i++){ // Iterate through the effective potions
-            if(contains(potions, b->effectivePotions[i])){ // Checks if the potion is known
-                Potion *p = get(potions,b->effectivePotions[i]);
 
-                if (p->potionCount > 0){
-                    p->potionCount -= 1;  // Decrease the amount of the potion
-                    canDefeat = 1; // Geralt can defeat the monster since we can at least utilize this specific potion
-                }
+/**
+ * @brief Geralt fights a monster without printing anything. Every effective potion in stock is used
+ * once and a win brings a trophy
+ * @param monsters The table containing the monsters
+ * @param potions The table containing the potions
+ * @param trophies The table containing the trophies
+ * @param monster The name of the monster
+ * @return 1 if Geralt defeats the monster, 0 if he is unprepared and nothing changes
+ */
+int defeatMonster(BestiaryTable *monsters, PotionTable *potions, CounterTable *trophies, Symbol monster){
+    if (!monsterKnown(monsters, monster)) // If the monster is new
+        return 0;
+
+    Bestiary *b = findMonster(monsters, monster);
+    int canDefeat = 0; // Boolean variable to check if Geralt can defeat the monster
+
+    for (int i = 0; i < b->potionCount; i++){ // Iterate through the effective potions
+        Potion *p = findPotion(potions, b->effectivePotions[i]);
+        if(p && p->recipe){ // Checks if the potion is known
+            if (p->potionCount > 0){
+                addToPotion(potions, b->effectivePotions[i], -1);  // Decrease the amount of the potion
+                canDefeat = 1; // Geralt can defeat the monster since we can at least utilize this specific potion
             }
         }
-        
-        if (b->signCount > 0) // There is a sign that can defeat the monster
-            canDefeat = 1;
+    }
 
-        if (!canDefeat){ // If Geralt does not know any effective potion or sign
-            printf("Geralt is unprepared and barely escapes with his life\n");
-            return;
-        }
+    if (b->signCount > 0) // There is a sign that can defeat the monster
+        canDefeat = 1;
 
-        if(contains(trophies, monster)){ // If trophy already exist
-            int *amount = get(trophies, monster);
-            int newAmount = *amount + 1; // Increase the amount of the trophy
-            update(trophies, monster, &newAmount, sizeof(int)); // Update the trophies hashmap
-        }
-        else{ // If the trophy is new
-            int amount = 1;
-            insert(trophies, monster, &amount, sizeof(int)); // Insert the trophy to the trophies Hashmap
-        }
-        printf("Geralt defeats %s\n" , monster);
-        return;
-    }
-    else{ // If the monster is new
-        printf("Geralt is unprepared and barely escapes with his life\n");
-        return;
+    if (!canDefeat) // If Geralt does not know any effective potion or sign
+        return 0;
+
+    addToCounter(trophies, monster, 1); // Increase the amount of the trophy
+    return 1;
+}
+
+/**
+ * @brief Geralt encounters a monster and tries to defeat it
+ * @param monsters The table containing the monsters
+ * @param potions The table containing the potions
+ * @param trophies The table containing the trophies
+ * @param monster The name of the monster
+ * @return 1 if Geralt defeats the monster, 0 otherwise
+ */
+int encounter(BestiaryTable *monsters, PotionTable *potions, CounterTable *trophies, Symbol monster){
+    if (!defeatMonster(monsters, potions, trophies, monster)){
+        outPrintf("Geralt is unprepared and barely escapes with his life\n");
+        return 0;
     }
-}
\ No newline at end of file
+
+    outPrintf("Geralt defeats %s\n" , symbolName(monster));
+    return 1;
+}
@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "arena.h"
+
+/**
+ * @brief Allocate an empty arena block
+ * @param capacity The number of bytes the block holds
+ * @return The block
+ */
+static ArenaBlock* newBlock(size_t capacity){
+    ArenaBlock *block = malloc(sizeof(ArenaBlock) + capacity);
+    if (block == NULL){
+        printf("Memory allocation failed!");
+        exit(EXIT_FAILURE);
+    }
+
+    block->next = NULL;
+    block->capacity = capacity;
+    block->used = 0;
+    return block;
+}
+
+/**
+ * @brief Initialize an arena with one block of ARENA_BLOCK_SIZE bytes
+ * @param arena The arena
+ */
+void initializeArena(Arena *arena){
+    arena->first = newBlock(ARENA_BLOCK_SIZE);
+    arena->current = arena->first;
+}
+
+/**
+ * @brief Take memory from the arena by moving a pointer. The memory is not freed on its own, it is
+ * given back all at once by resetArena
+ * @param arena The arena
+ * @param size The number of bytes
+ * @return Memory aligned to ARENA_ALIGNMENT
+ */
+void* arenaAlloc(Arena *arena, size_t size){
+    ArenaBlock *block = arena->current;
+    size = (size + ARENA_ALIGNMENT-1) & ~(size_t)(ARENA_ALIGNMENT-1);
+
+    if (block->capacity - block->used < size){ // Chain a larger block, resetArena merges the chain
+        size_t capacity = block->capacity*2;
+        while (capacity < size)
+            capacity *= 2;
+
+        block->next = newBlock(capacity);
+        block = block->next;
+        arena->current = block;
+    }
+
+    void *memory = block->data + block->used;
+    block->used += size;
+    return memory;
+}
+
+/**
+ * @brief Give back everything allocated from the arena. If the line needed more than one block, the
+ * blocks are replaced by a single block as large as all of them, so the next line of that size fits
+ * without allocating
+ * @param arena The arena
+ */
+void resetArena(Arena *arena){
+    if (arena->first->next){
+        size_t capacity = 0;
+        ArenaBlock *block = arena->first;
+
+        while (block){
+            ArenaBlock *next = block->next;
+            capacity += block->capacity;
+            free(block);
+            block = next;
+        }
+        arena->first = newBlock(capacity);
+    }
+
+    arena->first->used = 0;
+    arena->current = arena->first;
+}
+
+/**
+ * @brief Free every block of an arena
+ * @param arena The arena
+ */
+void freeArena(Arena *arena){
+    ArenaBlock *block = arena->first;
+
+    while (block){
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->first = NULL;
+    arena->current = NULL;
+}
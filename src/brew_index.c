@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "brew_index.h"
+
+/**
+ * @brief Count the brews one ingredient allows. A single brew checks every pair on its own and subtracts
+ * all of them, so an ingredient allows another brew while its amount covers its largest pair, and every
+ * brew takes its total
+ * @param ingredient The folded ingredient of a recipe
+ * @param available The amount of the ingredient
+ * @return The number of brews
+ */
+static int64_t allowedBrews(const StagedPair *ingredient, int64_t available){
+    if (available < ingredient->largest)
+        return 0;
+    return (available - ingredient->largest) / ingredient->total + 1;
+}
+
+/**
+ * @brief Find the smallest number of brews among the ingredients of a recipe
+ * @param p The potion, its recipe is learned
+ * @return The number of brews the ingredients allow together
+ */
+static int64_t bottleneck(const Potion *p){
+    int64_t smallest = p->allowed[0];
+    for (int i = 1; i < p->recipe->ingredientCount; i++){
+        if (p->allowed[i] < smallest)
+            smallest = p->allowed[i];
+    }
+    return smallest;
+}
+
+/**
+ * @brief Update the recipes that use an ingredient after its amount changed. A recipe only looks at
+ * its other ingredients when the changed one was its bottleneck and grew
+ * @param observer The brew index
+ * @param ingredient The symbol of the ingredient
+ */
+static void ingredientChanged(void *observer, Symbol ingredient){
+    BrewIndex *index = observer;
+    if ((int)ingredient >= index->capacity) // No recipe uses the ingredient
+        return;
+
+    const RecipeUses *list = &index->byIngredient[ingredient];
+    int64_t available = index->ingredients->entries[ingredient];
+
+    for (int i = 0; i < list->size; i++){
+        Potion *p = &index->potions->entries[list->uses[i].potion];
+        int slot = list->uses[i].slot;
+        int64_t before = p->allowed[slot];
+        int64_t allowed = allowedBrews(&p->recipe->ingredients[slot], available);
+
+        p->allowed[slot] = allowed;
+        if (allowed < p->brewable)
+            p->brewable = allowed;
+        else if (allowed > before && before == p->brewable) // Was the bottleneck, another one may be now
+            p->brewable = bottleneck(p);
+    }
+}
+
+/**
+ * @brief Initialize an empty index and start observing the ingredient table
+ * @param index The index
+ * @param potions The table containing the potions
+ * @param ingredients The table containing the ingredients
+ */
+void initializeBrewIndex(BrewIndex *index, PotionTable *potions, CounterTable *ingredients){
+    index->byIngredient = NULL;
+    index->capacity = 0;
+    index->potions = potions;
+    index->ingredients = ingredients;
+
+    ingredients->changed = ingredientChanged;
+    ingredients->observer = index;
+}
+
+/**
+ * @brief Add a recipe use to the list of an ingredient, growing the lists to cover the ingredient
+ * @param index The index
+ * @param ingredient The symbol of the ingredient
+ * @param use The recipe and the slot of the ingredient in it
+ */
+static void addUse(BrewIndex *index, Symbol ingredient, RecipeUse use){
+    if ((int)ingredient >= index->capacity){
+        int newCapacity = index->capacity ? index->capacity : 16;
+        while (newCapacity <= (int)ingredient)
+            newCapacity *= 2;
+
+        RecipeUses *newLists = realloc(index->byIngredient, newCapacity*sizeof(RecipeUses));
+        if (!newLists){
+            printf("Memory reallocation failed!");
+            exit(EXIT_FAILURE);
+        }
+        memset(newLists + index->capacity, 0, (newCapacity - index->capacity)*sizeof(RecipeUses));
+        index->byIngredient = newLists;
+        index->capacity = newCapacity;
+    }
+
+    RecipeUses *list = &index->byIngredient[ingredient];
+    if (list->size == list->capacity){
+        list->capacity = list->capacity ? list->capacity*2 : 4;
+        list->uses = realloc(list->uses, list->capacity*sizeof(RecipeUse));
+        if (!list->uses){
+            printf("Memory reallocation failed!");
+            exit(EXIT_FAILURE);
+        }
+    }
+    list->uses[list->size++] = use;
+}
+
+/**
+ * @brief Index a recipe that was just learned and compute how many times it can be brewed. Every
+ * ingredient of the recipe gets a counter slot, unseen ingredients start at 0 and are not listed
+ * @param index The index
+ * @param potion The symbol of the potion, its recipe is set
+ */
+void indexRecipe(BrewIndex *index, Symbol potion){
+    Potion *p = findPotion(index->potions, potion);
+    const Recipe *r = p->recipe;
+
+    p->allowed = malloc(r->ingredientCount*sizeof(int64_t));
+    if (!p->allowed){
+        printf("Memory allocation failed!");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < r->ingredientCount; i++){
+        const StagedPair *ingredient = &r->ingredients[i];
+        int64_t available = *entryCounter(index->ingredients, ingredient->key);
+
+        p->allowed[i] = allowedBrews(ingredient, available);
+        addUse(index, ingredient->key, (RecipeUse){potion, i});
+    }
+    p->brewable = bottleneck(p);
+}
+
+/**
+ * @brief Free the lists of an index and stop observing the ingredient table
+ * @param index The index
+ */
+void freeBrewIndex(BrewIndex *index){
+    for (int i = 0; i < index->capacity; i++)
+        free(index->byIngredient[i].uses);
+    free(index->byIngredient);
+
+    if (index->ingredients->observer == index){
+        index->ingredients->changed = NULL;
+        index->ingredients->observer = NULL;
+    }
+    index->byIngredient = NULL;
+    index->capacity = 0;
+}
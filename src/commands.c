@@ -0,0 +1,497 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "commands.h"
+#include "actions.h"
+#include "queries.h"
+#include "helper_methods.h"
+#include "symbols.h"
+#include "snapshot.h"
+#include "journal.h"
+#include "output.h"
+
+/**
+ * @brief Intern the text of a word or name argument, unless its symbol was looked up already
+ * @param command The command
+ * @param index The index of the argument
+ * @return The symbol of the argument
+ */
+static Symbol argumentSymbol(const Command *command, int index){
+    const Argument *argument = &command->arguments[index];
+    if (argument->symbol != NO_SYMBOL)
+        return argument->symbol;
+    return internSymbolSlice(command->line + argument->text.offset, argument->text.length);
+}
+
+/**
+ * @brief Look the text of a word or name argument up without interning it. Queries use it, a name that
+ * was never interned has no entry in any table
+ * @param command The command
+ * @param index The index of the argument
+ * @return The symbol of the argument, NO_SYMBOL if the name was never interned
+ */
+static Symbol argumentLookup(const Command *command, int index){
+    const Argument *argument = &command->arguments[index];
+    if (argument->symbol != NO_SYMBOL)
+        return argument->symbol;
+    return lookupSymbolSlice(command->line + argument->text.offset, argument->text.length);
+}
+
+/**
+ * @brief Get the name of a word or name argument for an answer
+ * @param command The command
+ * @param index The index of the argument
+ * @param symbol The symbol of the argument, NO_SYMBOL if the name was never interned
+ * @param scratch The arena of the line, it owns the copy of a name that was never interned
+ * @return The name
+ */
+static const char* argumentName(const Command *command, int index, Symbol symbol, Arena *scratch){
+    if (symbol != NO_SYMBOL)
+        return symbolName(symbol);
+
+    const Token *text = &command->arguments[index].text;
+    char *name = arenaAlloc(scratch, text->length + 1);
+    memcpy(name, command->line + text->offset, text->length);
+    name[text->length] = '\0';
+    return name;
+}
+
+/**
+ * @brief Build the path of a snapshot argument inside the snapshot directory. Lines may come from untrusted
+ * logs or clients, so the argument must be a plain file name, it can not leave the directory
+ * @param inventory The inventory, it holds the snapshot directory
+ * @param command The command
+ * @param index The index of the argument
+ * @param scratch The arena of the line, it owns the string
+ * @return The path, NULL if there is no snapshot directory or the argument is not a plain file name
+ */
+static const char* argumentSnapshotPath(const Inventory *inventory, const Command *command, int index, Arena *scratch){
+    const Token *text = &command->arguments[index].text;
+    const char *name = command->line + text->offset;
+
+    if (!inventory->snapshotDirectory)
+        return NULL;
+    if (memchr(name, '/', text->length) || memchr(name, '\0', text->length)) // Names only, no directories
+        return NULL;
+    if ((text->length == 1 && name[0] == '.') || (text->length == 2 && name[0] == '.' && name[1] == '.'))
+        return NULL;
+
+    size_t directoryLength = strlen(inventory->snapshotDirectory);
+    char *path = arenaAlloc(scratch, directoryLength + 1 + text->length + 1);
+    memcpy(path, inventory->snapshotDirectory, directoryLength);
+    path[directoryLength] = '/';
+    memcpy(path + directoryLength + 1, name, text->length);
+    path[directoryLength + 1 + text->length] = '\0';
+    return path;
+}
+
+/**
+ * @brief Build the PairArray of a pairs argument
+ * @param command The command
+ * @param index The index of the argument
+ * @param scratch The arena of the line, it owns the PairArray
+ * @return The PairArray
+ */
+static PairArray* argumentPairs(const Command *command, int index, Arena *scratch){
+    const Argument *argument = &command->arguments[index];
+    return constructPairArray(scratch, command->line, &command->tokens[argument->start], argument->count);
+}
+
+static void lootCommand(Inventory *inventory, const Command *command, Arena *scratch){
+    PairArray *lootArray = argumentPairs(command, 0, scratch);
+    loot(inventory->ingredients, lootArray);
+    if (inventory->journal)
+        journalCounters(inventory->journal, NULL, lootArray);
+}
+
+static void tradeCommand(Inventory *inventory, const Command *command, Arena *scratch){
+    PairArray *trophyArray = argumentPairs(command, 0, scratch);
+    PairArray *ingredientArray = argumentPairs(command, 1, scratch);
+    if (trade(inventory->ingredients, inventory->trophies, ingredientArray, trophyArray) && inventory->journal)
+        journalCounters(inventory->journal, trophyArray, ingredientArray);
+}
+
+static void brewCommand(Inventory *inventory, const Command *command, Arena *scratch){
+    (void)scratch;
+    Symbol potion = argumentSymbol(command, 0);
+    if (brew(inventory->potions, inventory->ingredients, potion, 1) > 0 && inventory->journal)
+        journalBrew(inventory->journal, potion, 1);
+}
+
+static void brewManyCommand(Inventory *inventory, const Command *command, Arena *scratch){
+    (void)scratch;
+    int times = command->arguments[0].text.value;
+    if (times > MAX_BREWS){
+        outPrintf("INVALID\n");
+        return;
+    }
+
+    Symbol potion = argumentSymbol(command, 1);
+    int64_t brewed = brew(inventory->potions, inventory->ingredients, potion, times); // One line per brew, as single brews print
+    outPrintf("Alchemy items created: %" PRId64 " %s\n", brewed, symbolName(potion));
+    if (brewed > 0 && inventory->journal)
+        journalBrew(inventory->journal, potion, brewed);
+}
+
+static void learnRecipeCommand(Inventory *inventory, const Command *command, Arena *scratch){
+    Symbol potion = argumentSymbol(command, 0);
+    PairArray *ingredients = argumentPairs(command, 1, scratch);
+    if (learnPotionRecipe(inventory->potions, inventory->brewIndex, potion, ingredients) && inventory->journal) // A new recipe is copied out of the arena
+        journalRecipe(inventory->journal, potion, ingredients);
+}
+
+static void learnSignCommand(Inventory *inventory, const Command *command, Arena *scratch){
+    (void)scratch;
+    Symbol monster = argumentSymbol(command, 1);
+    Symbol sign = argumentSymbol(command, 0);
+    if (learnSign(inventory->monsters, monster, sign) && inventory->journal)
+        journalSign(inventory->journal, monster, sign);
+}
+
+static void learnPotionCommand(Inventory *inventory, const Command *command, Arena *scratch){
+    (void)scratch;
+    Symbol monster = argumentSymbol(command, 1);
+    Symbol potion = argumentSymbol(command, 0);
+    if (learnPotion(inventory->monsters, monster, potion) && inventory->journal)
+        journalEffective(inventory->journal, monster, potion);
+}
+
+static void encounterCommand(Inventory *inventory, const Command *command, Arena *scratch){
+    (void)scratch;
+    Symbol monster = argumentSymbol(command, 0);
+    if (encounter(inventory->monsters, inventory->potions, inventory->trophies, monster) && inventory->journal)
+        journalEncounter(inventory->journal, monster);
+}
+
+static void allIngredientsCommand(Inventory *inventory, const Command *command, Arena *scratch){
+    (void)command;
+    (void)scratch;
+    allIngredients(inventory->ingredients);
+}
+
+static void specificIngredientCommand(Inventory *inventory, const Command *command, Arena *scratch){
+    (void)scratch;
+    specificIngredients(inventory->ingredients, argumentLookup(command, 0));
+}
+
+static void allPotionsCommand(Inventory *inventory, const Command *command, Arena *scratch){
+    (void)command;
+    (void)scratch;
+    allPotions(inventory->potions);
+}
+
+static void specificPotionCommand(Inventory *inventory, const Command *command, Arena *scratch){
+    (void)scratch;
+    specificPotion(inventory->potions, argumentLookup(command, 0));
+}
+
+static void allTrophiesCommand(Inventory *inventory, const Command *command, Arena *scratch){
+    (void)command;
+    (void)scratch;
+    allTrophies(inventory->trophies);
+}
+
+static void specificTrophyCommand(Inventory *inventory, const Command *command, Arena *scratch){
+    (void)scratch;
+    specificTrophies(inventory->trophies, argumentLookup(command, 0));
+}
+
+static void potionFormulaCommand(Inventory *inventory, const Command *command, Arena *scratch){
+    Symbol symbol = argumentLookup(command, 0);
+    potionFormula(inventory->potions, symbol, argumentName(command, 0, symbol, scratch));
+}
+
+static void specificBrewableCommand(Inventory *inventory, const Command *command, Arena *scratch){
+    Symbol symbol = argumentLookup(command, 0);
+    specificBrewable(inventory->potions, symbol, argumentName(command, 0, symbol, scratch));
+}
+
+static void allBrewableCommand(Inventory *inventory, const Command *command, Arena *scratch){
+    (void)command;
+    (void)scratch;
+    allBrewable(inventory->potions);
+}
+
+static void effectivenessCommand(Inventory *inventory, const Command *command, Arena *scratch){
+    Symbol symbol = argumentLookup(command, 0);
+    potionSignEffectiveness(inventory->monsters, symbol, argumentName(command, 0, symbol, scratch));
+}
+
+static void saveCommand(Inventory *inventory, const Command *command, Arena *scratch){
+    const char *path = argumentSnapshotPath(inventory, command, 0, scratch);
+    if (!path || !saveSnapshot(inventory, path)){
+        outPrintf("Can not save snapshot\n");
+        return;
+    }
+    if (inventory->journal && !checkpointJournal(inventory->journal, inventory)){ // The old journal still holds every change
+        outPrintf("Snapshot saved, can not checkpoint journal\n");
+        return;
+    }
+    outPrintf("Snapshot saved\n");
+}
+
+static void loadCommand(Inventory *inventory, const Command *command, Arena *scratch){
+    const char *path = argumentSnapshotPath(inventory, command, 0, scratch);
+    if (!path || !loadSnapshot(inventory, path, scratch)){ // The inventory is replaced as a whole
+        outPrintf("Can not load snapshot\n");
+        return;
+    }
+    if (inventory->journal && !checkpointJournal(inventory->journal, inventory)){ // The journal no longer describes the tables
+        fprintf(stderr, "Journal checkpoint failed\n");
+        exit(EXIT_FAILURE);
+    }
+    outPrintf("Snapshot loaded\n");
+}
+
+/*
+ * The grammar. Every pattern starts with two keywords, rules with the same two keywords are tried in
+ * table order and the first one that matches the whole line wins. A new command is a new row.
+ */
+static const CommandRule commandTable[] = {
+    // Handler, minimum and maximum number of tokens, pattern
+    {lootCommand, 4, ANY_LENGTH, {KW_GERALT, KW_LOOTS, P_PAIRS}},
+    {tradeCommand, 8, ANY_LENGTH, {KW_GERALT, KW_TRADES, P_PAIRS, KW_TROPHY, KW_FOR, P_PAIRS}},
+    {brewCommand, 3, ANY_LENGTH, {KW_GERALT, KW_BREWS, P_NAME}},
+    {brewManyCommand, 4, ANY_LENGTH, {KW_GERALT, KW_BREWS, P_NUMBER, P_NAME}},
+    {learnRecipeCommand, 8, ANY_LENGTH, {KW_GERALT, KW_LEARNS, P_NAME, KW_POTION, KW_CONSISTS, KW_OF, P_PAIRS}},
+    {learnSignCommand, 8, 8, {KW_GERALT, KW_LEARNS, P_WORD, KW_SIGN, KW_IS, KW_EFFECTIVE, KW_AGAINST, P_WORD}},
+    {learnPotionCommand, 8, ANY_LENGTH, {KW_GERALT, KW_LEARNS, P_NAME, KW_POTION, KW_IS, KW_EFFECTIVE, KW_AGAINST, P_WORD}},
+    {encounterCommand, 4, 4, {KW_GERALT, KW_ENCOUNTERS, KW_A, P_WORD}},
+    {allIngredientsCommand, 3, 3, {KW_TOTAL, KW_INGREDIENT, P_QMARK}},
+    {specificIngredientCommand, 4, 4, {KW_TOTAL, KW_INGREDIENT, P_WORD, P_QMARK}},
+    {allPotionsCommand, 3, 3, {KW_TOTAL, KW_POTION, P_QMARK}},
+    {specificPotionCommand, 4, ANY_LENGTH, {KW_TOTAL, KW_POTION, P_NAME, P_QMARK}},
+    {allTrophiesCommand, 3, 3, {KW_TOTAL, KW_TROPHY, P_QMARK}},
+    {specificTrophyCommand, 4, 4, {KW_TOTAL, KW_TROPHY, P_WORD, P_QMARK}},
+    {potionFormulaCommand, 5, ANY_LENGTH, {KW_WHAT, KW_IS, KW_IN, P_NAME, P_QMARK}},
+    {effectivenessCommand, 6, 6, {KW_WHAT, KW_IS, KW_EFFECTIVE, KW_AGAINST, P_WORD, P_QMARK}},
+    {effectivenessCommand, 7, 7, {KW_WHAT, KW_IS, KW_EFFECTIVE, KW_AGAINST, P_SKIP, P_WORD, P_ATTACHED_QMARK}}, // Two words, the last one is the monster as it always was
+    {specificBrewableCommand, 7, ANY_LENGTH, {KW_HOW, KW_MANY, P_NAME, KW_CAN, KW_BE, KW_BREWED, P_QMARK}},
+    {allBrewableCommand, 5, 5, {KW_WHAT, KW_CAN, KW_BE, KW_BREWED, P_QMARK}},
+    {saveCommand, 3, 3, {KW_SAVE, KW_TO, P_PATH}},
+    {loadCommand, 3, 3, {KW_LOAD, KW_FROM, P_PATH}},
+};
+
+#define COMMAND_COUNT ((int)(sizeof(commandTable)/sizeof(commandTable[0])))
+
+static int firstRule[KW_COUNT][KW_COUNT]; // First rule for a pair of leading keywords, -1 if there is none
+static int nextRule[COMMAND_COUNT]; // Next rule with the same leading keywords, -1 at the end
+static int tableReady = 0;
+
+/**
+ * @brief Chain the rules by their two leading keywords. parseCommand does it before the first line, threads
+ * that parse at the same time call it once before they start
+ */
+void initializeCommandTable(void){
+    if (tableReady)
+        return;
+
+    for (int i = 0; i < KW_COUNT; i++)
+        for (int j = 0; j < KW_COUNT; j++)
+            firstRule[i][j] = -1;
+
+    for (int i = COMMAND_COUNT-1; i >= 0; i--){ // Backwards so every chain keeps table order
+        int first = commandTable[i].pattern[0];
+        int second = commandTable[i].pattern[1];
+
+        nextRule[i] = firstRule[first][second];
+        firstRule[first][second] = i;
+    }
+    tableReady = 1;
+}
+
+/**
+ * @brief Check if a token is a fixed element of a pattern
+ * @param element The keyword, P_QMARK or P_ATTACHED_QMARK
+ * @param token The token
+ * @return 1 if the token is that element, 0 otherwise
+ */
+static int matchesElement(int element, const Token *token){
+    if (element == P_QMARK)
+        return token->type == TOKEN_QMARK;
+    if (element == P_ATTACHED_QMARK) // Never the first token, so there is one before it
+        return token->type == TOKEN_QMARK && token->offset == token[-1].offset + token[-1].length;
+    return token->type == TOKEN_WORD && (int)token->keyword == element;
+}
+
+/**
+ * @brief Find where a name or pairs argument ends, at the first token after its start that is the element
+ * following it in the pattern
+ * @param next The element after the argument
+ * @param tokens The tokens of the line
+ * @param start The index of the first token of the argument
+ * @param size The number of tokens
+ * @return The index one past the last token of the argument
+ */
+static int argumentEnd(int next, const Token *tokens, int start, int size){
+    if (next == P_END) // The argument runs to the end of the line
+        return size;
+
+    for (int i = start+1; i < size; i++){
+        if (matchesElement(next, &tokens[i]))
+            return i;
+    }
+    return size; // The element is missing, the pattern fails on it
+}
+
+/**
+ * @brief Match a line against one row of the command table
+ * @param rule The row
+ * @param line The line
+ * @param tokens The tokens of the line
+ * @param size The number of tokens
+ * @param command Receives the arguments
+ * @return 1 if the whole line matches the row, 0 otherwise
+ */
+static int matchRule(const CommandRule *rule, const char *line, const Token *tokens, int size, Command *command){
+    int position = 0; // Next token to match
+    int argumentCount = 0;
+
+    if (size < rule->minTokens || size > rule->maxTokens)
+        return 0;
+
+    for (int e = 0; rule->pattern[e] != P_END; e++){
+        int element = rule->pattern[e];
+
+        if (element == P_NAME || element == P_PAIRS){
+            Argument *argument = &command->arguments[argumentCount++];
+            argument->start = position;
+            argument->symbol = NO_SYMBOL;
+            argument->count = argumentEnd(rule->pattern[e+1], tokens, position, size) - position;
+
+            if (element == P_NAME && !joinName(line, &tokens[position], argument->count, &argument->text))
+                return 0;
+            if (element == P_PAIRS && !checkPairs(line, &tokens[position], argument->count))
+                return 0;
+            position += argument->count;
+        }
+        else if (position >= size){ // Line ended too early
+            return 0;
+        }
+        else if (element == P_WORD || element == P_NUMBER || element == P_PATH){
+            if (element == P_WORD && !isWordName(line, &tokens[position]))
+                return 0;
+            if (element == P_NUMBER && tokens[position].type != TOKEN_NUMBER)
+                return 0;
+            if (element == P_PATH && tokens[position].type != TOKEN_WORD && tokens[position].type != TOKEN_NUMBER)
+                return 0;
+
+            Argument *argument = &command->arguments[argumentCount++];
+            argument->start = position;
+            argument->count = 1;
+            argument->text = tokens[position];
+            argument->symbol = NO_SYMBOL;
+            position++;
+        }
+        else if (element == P_SKIP){
+            if (tokens[position].type != TOKEN_WORD && tokens[position].type != TOKEN_NUMBER)
+                return 0;
+            position++;
+        }
+        else{
+            if (!matchesElement(element, &tokens[position]))
+                return 0;
+            position++;
+        }
+    }
+
+    return position == size; // Nothing may follow the pattern
+}
+
+/**
+ * @brief Find the command of a line. The two leading keywords select the candidate rules directly,
+ * only those are matched against the rest of the line
+ * @param line The line, it does not need to be NUL terminated
+ * @param tokens The tokens of the line
+ * @param size The number of tokens
+ * @param command Receives the matching rule and its arguments
+ * @return 1 if the line is a valid command, 0 otherwise
+ */
+int parseCommand(const char *line, const Token *tokens, int size, Command *command){
+    if (!tableReady)
+        initializeCommandTable();
+
+    if (size < 2)
+        return 0;
+
+    command->line = line;
+    command->tokens = tokens;
+
+    for (int i = firstRule[tokens[0].keyword][tokens[1].keyword]; i != -1; i = nextRule[i]){
+        if (matchRule(&commandTable[i], line, tokens, size, command)){
+            command->rule = &commandTable[i];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Look up the symbols of the word and name arguments of a parsed command without interning them,
+ * so a thread other than the executing one can take that work. Names seen for the first time are left
+ * to argumentSymbol
+ * @param command The command returned by parseCommand
+ * @param reader The symbol reader slot of the calling thread
+ */
+void resolveArguments(Command *command, int reader){
+    int argumentCount = 0;
+
+    for (int e = 0; command->rule->pattern[e] != P_END; e++){
+        int element = command->rule->pattern[e];
+        if (element > 0 || element == P_QMARK || element == P_ATTACHED_QMARK || element == P_SKIP) // Keywords, "?" and skipped tokens are not arguments
+            continue;
+
+        Argument *argument = &command->arguments[argumentCount++];
+        if (element == P_WORD || element == P_NAME)
+            argument->symbol = findSymbolSlice(reader, command->line + argument->text.offset, argument->text.length);
+    }
+}
+
+/**
+ * @brief Run a command returned by parseCommand
+ * @param inventory The tables the command reads and updates
+ * @param command The command
+ * @param scratch The arena of the line, the caller resets it once the command is done
+ */
+void executeCommand(Inventory *inventory, const Command *command, Arena *scratch){
+    command->rule->handler(inventory, command, scratch);
+}
+
+/**
+ * @brief Allocate the four tables of an inventory
+ * @param inventory The inventory
+ */
+void initializeInventory(Inventory *inventory){
+    inventory->ingredients = malloc(sizeof(CounterTable));  // Pointer to ingredients table
+    inventory->trophies = malloc(sizeof(CounterTable));  // Pointer to trophies table
+    inventory->potions = malloc(sizeof(PotionTable));  // Pointer to potions table
+    inventory->monsters = malloc(sizeof(BestiaryTable));  // Pointer to monsters table
+    inventory->brewIndex = malloc(sizeof(BrewIndex));  // Pointer to the recipes of every ingredient
+
+    if (!inventory->ingredients || !inventory->trophies || !inventory->potions || !inventory->monsters || !inventory->brewIndex){
+        printf("Memory allocation failed!");
+        exit(EXIT_FAILURE);
+    }
+
+    initializeTableCounter(inventory->ingredients);
+    initializeTableCounter(inventory->trophies);
+    initializeTablePotion(inventory->potions);
+    initializeTableMonster(inventory->monsters);
+    initializeBrewIndex(inventory->brewIndex, inventory->potions, inventory->ingredients);
+    inventory->journal = NULL;
+    inventory->snapshotDirectory = NULL;
+}
+
+/**
+ * @brief Free the four tables of an inventory
+ * @param inventory The inventory
+ */
+void freeInventory(Inventory *inventory){
+    freeBrewIndex(inventory->brewIndex); // Before the ingredient table it observes
+    free(inventory->brewIndex);
+    freeTableCounter(inventory->ingredients);
+    freeTableCounter(inventory->trophies);
+    freeTablePotion(inventory->potions);
+    freeTableMonster(inventory->monsters);
+}
@@ -0,0 +1,359 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "concurrent_map.h"
+#include "hash.h"
+
+/**
+ * @brief Allocate a bucket array with every chain empty
+ * @param buckets The number of buckets, a power of two
+ * @return The table
+ */
+static ConcurrentTable* allocateTable(size_t buckets){
+    ConcurrentTable *table = malloc(sizeof(ConcurrentTable) + buckets*sizeof(table->buckets[0]));
+    if (!table){
+        printf("Memory allocation failed!");
+        exit(EXIT_FAILURE);
+    }
+
+    table->mask = buckets - 1;
+    for (size_t i = 0; i < buckets; i++)
+        atomic_init(&table->buckets[i], NULL);
+    return table;
+}
+
+/**
+ * @brief Allocate a node that is not linked yet
+ * @param map The map
+ * @param hash The hash of the key
+ * @param key The key, NUL terminated and owned by the map
+ * @param length The length of the key
+ * @param value The value, map->valueSize bytes are copied
+ * @return The node
+ */
+static ConcurrentNode* createNode(ConcurrentMap *map, uint64_t hash, char *key, size_t length, const void *value){
+    ConcurrentNode *node = malloc(sizeof(ConcurrentNode) + map->valueSize);
+    if (!node){
+        printf("Memory allocation failed!");
+        exit(EXIT_FAILURE);
+    }
+
+    atomic_init(&node->next, NULL);
+    node->hash = hash;
+    node->key = key;
+    node->length = length;
+    memcpy(node->value, value, map->valueSize);
+    return node;
+}
+
+/**
+ * @brief Release a node that was replaced by a copy, the copy keeps the key
+ * @param item The node
+ */
+static void releaseNode(void *item){
+    free(item);
+}
+
+/**
+ * @brief Release a deleted node and its key
+ * @param item The node
+ */
+static void releaseNodeAndKey(void *item){
+    ConcurrentNode *node = item;
+    free(node->key);
+    free(node);
+}
+
+/**
+ * @brief Release a bucket array that was replaced by a larger one, the copies in the new array keep the keys
+ * @param item The table
+ */
+static void releaseTable(void *item){
+    ConcurrentTable *table = item;
+    for (size_t i = 0; i <= table->mask; i++){
+        ConcurrentNode *node = atomic_load_explicit(&table->buckets[i], memory_order_relaxed);
+        while (node){
+            ConcurrentNode *next = atomic_load_explicit(&node->next, memory_order_relaxed);
+            free(node);
+            node = next;
+        }
+    }
+    free(table);
+}
+
+/**
+ * @brief Initialize the map
+ * @param map The map
+ * @param capacity The number of keys expected, the bucket array starts large enough for them
+ * @param valueSize The size of the value stored with every key
+ */
+void initializeConcurrentMap(ConcurrentMap *map, int capacity, size_t valueSize){
+    size_t buckets = CONCURRENT_INITIAL_BUCKETS;
+    while (buckets*CONCURRENT_LOAD_FACTOR < (size_t)capacity)
+        buckets *= 2;
+
+    atomic_init(&map->table, allocateTable(buckets));
+    for (int i = 0; i < CONCURRENT_STRIPES; i++)
+        pthread_mutex_init(&map->stripes[i].lock, NULL);
+    atomic_init(&map->size, 0);
+    map->valueSize = valueSize;
+    map->seed = processHashSeed();
+    initializeEpochs(&map->epochs);
+}
+
+/**
+ * @brief Give a thread its reader slot, once before its first concurrentGet
+ * @param map The map
+ * @return The reader slot
+ */
+int registerMapReader(ConcurrentMap *map){
+    return registerEpochReader(&map->epochs);
+}
+
+/**
+ * @brief Find the node of a key in a chain
+ * @param node The first node of the chain
+ * @param key The key, it does not need to be NUL terminated
+ * @param length The length of the key
+ * @param hash The hash of the key
+ * @return The node, NULL if the key is not in the chain
+ */
+static ConcurrentNode* findNode(ConcurrentNode *node, const char *key, size_t length, uint64_t hash){
+    while (node){
+        if (node->hash == hash && node->length == length && memcmp(node->key, key, length) == 0)
+            return node;
+        node = atomic_load_explicit(&node->next, memory_order_acquire);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Read the value of a key without taking a lock, any number of threads may read while others write
+ * @param map The map
+ * @param reader The reader slot of the calling thread, see registerMapReader
+ * @param key The key, it does not need to be NUL terminated
+ * @param length The length of the key
+ * @param value Receives a copy of the value if the key is found, may be NULL
+ * @return 1 if the key is in the map, 0 otherwise
+ */
+int concurrentGet(ConcurrentMap *map, int reader, const char *key, size_t length, void *value){
+    uint64_t hash = hashBytes(key, length, map->seed);
+
+    epochEnter(&map->epochs, reader);
+    ConcurrentTable *table = atomic_load_explicit(&map->table, memory_order_acquire);
+    ConcurrentNode *node = findNode(atomic_load_explicit(&table->buckets[hash & table->mask], memory_order_acquire), key, length, hash);
+    if (node && value)
+        memcpy(value, node->value, map->valueSize); // Copied while the node can not be freed
+    epochExit(&map->epochs, reader);
+
+    return node != NULL;
+}
+
+/**
+ * @brief Double the bucket array if no other writer did it since it was seen. Every stripe is locked, so
+ * nothing changes while the nodes are copied
+ * @param map The map
+ * @param seen The number of buckets the writer found too full
+ */
+static void growTable(ConcurrentMap *map, size_t seen){
+    ConcurrentTable *grown = NULL;
+
+    for (int i = 0; i < CONCURRENT_STRIPES; i++) // Always in the same order, so two writers can not deadlock
+        pthread_mutex_lock(&map->stripes[i].lock);
+
+    ConcurrentTable *table = atomic_load_explicit(&map->table, memory_order_relaxed);
+    if (table->mask + 1 == seen){ // Arrays only grow, so a larger one was already built by another writer
+        grown = allocateTable((table->mask + 1)*2);
+        for (size_t i = 0; i <= table->mask; i++){
+            ConcurrentNode *node = atomic_load_explicit(&table->buckets[i], memory_order_relaxed);
+            for (; node; node = atomic_load_explicit(&node->next, memory_order_relaxed)){
+                ConcurrentNode *copy = createNode(map, node->hash, node->key, node->length, node->value);
+                _Atomic(ConcurrentNode *) *bucket = &grown->buckets[node->hash & grown->mask];
+                atomic_store_explicit(&copy->next, atomic_load_explicit(bucket, memory_order_relaxed), memory_order_relaxed);
+                atomic_store_explicit(bucket, copy, memory_order_relaxed);
+            }
+        }
+        atomic_store_explicit(&map->table, grown, memory_order_release); // Publishes every copy
+    }
+
+    for (int i = CONCURRENT_STRIPES-1; i >= 0; i--)
+        pthread_mutex_unlock(&map->stripes[i].lock);
+
+    if (grown) // Readers may still walk the old array
+        epochRetire(&map->epochs, table, releaseTable);
+}
+
+/**
+ * @brief Link a new key at the front of its chain. The caller holds the stripe of the key
+ * @param map The map
+ * @param table The bucket array
+ * @param hash The hash of the key
+ * @param key The key, it does not need to be NUL terminated, the map stores a NUL terminated copy
+ * @param length The length of the key
+ * @param value The value
+ * @return The node
+ */
+static ConcurrentNode* linkNew(ConcurrentMap *map, ConcurrentTable *table, uint64_t hash, const char *key, size_t length, const void *value){
+    char *newKey = malloc(length+1);
+    if (!newKey){
+        printf("Memory allocation failed!");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(newKey, key, length);
+    newKey[length] = '\0';
+
+    ConcurrentNode *node = createNode(map, hash, newKey, length, value);
+    _Atomic(ConcurrentNode *) *bucket = &table->buckets[hash & table->mask];
+    atomic_store_explicit(&node->next, atomic_load_explicit(bucket, memory_order_relaxed), memory_order_relaxed);
+    atomic_store_explicit(bucket, node, memory_order_release); // Readers see the node only once it is complete
+    atomic_fetch_add_explicit(&map->size, 1, memory_order_relaxed);
+    return node;
+}
+
+/**
+ * @brief Grow the bucket array once the keys outnumber the buckets too much. The caller holds no stripe, so
+ * the array it used may already be replaced and freed, only its size read under the stripe is used
+ * @param map The map
+ * @param buckets The number of buckets of the array the key went into
+ */
+static void growIfFull(ConcurrentMap *map, size_t buckets){
+    if ((size_t)atomic_load_explicit(&map->size, memory_order_relaxed) > buckets*CONCURRENT_LOAD_FACTOR)
+        growTable(map, buckets);
+}
+
+/**
+ * @brief Find a key, inserting it with a value if it is missing
+ * @param map The map
+ * @param key The key, it does not need to be NUL terminated
+ * @param length The length of the key
+ * @param value The value of the key if it is inserted
+ * @param found Receives a copy of the value already in the map if the key was there, may be NULL
+ * @param storedKey Receives the NUL terminated key of the map, valid until the key is deleted, may be NULL
+ * @return 1 if the key was inserted, 0 if it was already in the map
+ */
+int concurrentFindOrInsert(ConcurrentMap *map, const char *key, size_t length, const void *value, void *found, const char **storedKey){
+    uint64_t hash = hashBytes(key, length, map->seed);
+    MapStripe *stripe = &map->stripes[hash & (CONCURRENT_STRIPES-1)];
+
+    pthread_mutex_lock(&stripe->lock);
+    ConcurrentTable *table = atomic_load_explicit(&map->table, memory_order_relaxed); // Only replaced with every stripe held
+    ConcurrentNode *node = findNode(atomic_load_explicit(&table->buckets[hash & table->mask], memory_order_relaxed), key, length, hash);
+
+    size_t buckets = table->mask + 1;
+    int inserted = 0;
+    if (node){
+        if (found)
+            memcpy(found, node->value, map->valueSize);
+    }
+    else{
+        node = linkNew(map, table, hash, key, length, value);
+        inserted = 1;
+    }
+    if (storedKey)
+        *storedKey = node->key;
+    pthread_mutex_unlock(&stripe->lock);
+
+    if (inserted)
+        growIfFull(map, buckets);
+    return inserted;
+}
+
+/**
+ * @brief Set the value of a key, inserting the key if it is missing. Readers see either the old or the new value
+ * @param map The map
+ * @param key The key, it does not need to be NUL terminated
+ * @param length The length of the key
+ * @param value The value, map->valueSize bytes are copied
+ */
+void concurrentPut(ConcurrentMap *map, const char *key, size_t length, const void *value){
+    uint64_t hash = hashBytes(key, length, map->seed);
+    MapStripe *stripe = &map->stripes[hash & (CONCURRENT_STRIPES-1)];
+    ConcurrentNode *replaced = NULL;
+
+    pthread_mutex_lock(&stripe->lock);
+    ConcurrentTable *table = atomic_load_explicit(&map->table, memory_order_relaxed);
+    _Atomic(ConcurrentNode *) *link = &table->buckets[hash & table->mask];
+    ConcurrentNode *node;
+
+    for (node = atomic_load_explicit(link, memory_order_relaxed); node; node = atomic_load_explicit(link, memory_order_relaxed)){
+        if (node->hash == hash && node->length == length && memcmp(node->key, key, length) == 0)
+            break;
+        link = &node->next;
+    }
+
+    if (node){ // A copy with the new value takes the place of the node
+        ConcurrentNode *copy = createNode(map, hash, node->key, length, value);
+        atomic_store_explicit(&copy->next, atomic_load_explicit(&node->next, memory_order_relaxed), memory_order_relaxed);
+        atomic_store_explicit(link, copy, memory_order_release);
+        replaced = node;
+    }
+    else{
+        linkNew(map, table, hash, key, length, value);
+    }
+    size_t buckets = table->mask + 1;
+    pthread_mutex_unlock(&stripe->lock);
+
+    if (replaced)
+        epochRetire(&map->epochs, replaced, releaseNode);
+    else
+        growIfFull(map, buckets);
+}
+
+/**
+ * @brief Delete a key
+ * @param map The map
+ * @param key The key, it does not need to be NUL terminated
+ * @param length The length of the key
+ * @return 1 if the key was deleted, 0 if it was not in the map
+ */
+int concurrentDelete(ConcurrentMap *map, const char *key, size_t length){
+    uint64_t hash = hashBytes(key, length, map->seed);
+    MapStripe *stripe = &map->stripes[hash & (CONCURRENT_STRIPES-1)];
+
+    pthread_mutex_lock(&stripe->lock);
+    ConcurrentTable *table = atomic_load_explicit(&map->table, memory_order_relaxed);
+    _Atomic(ConcurrentNode *) *link = &table->buckets[hash & table->mask];
+    ConcurrentNode *node;
+
+    for (node = atomic_load_explicit(link, memory_order_relaxed); node; node = atomic_load_explicit(link, memory_order_relaxed)){
+        if (node->hash == hash && node->length == length && memcmp(node->key, key, length) == 0)
+            break;
+        link = &node->next;
+    }
+
+    if (node){ // Readers already on the node still reach the rest of the chain through it
+        atomic_store_explicit(link, atomic_load_explicit(&node->next, memory_order_relaxed), memory_order_release);
+        atomic_fetch_sub_explicit(&map->size, 1, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&stripe->lock);
+
+    if (node)
+        epochRetire(&map->epochs, node, releaseNodeAndKey);
+    return node != NULL;
+}
+
+/**
+ * @brief Free the keys and nodes of the map and everything still retired, no other thread may use the map
+ * @param map The map
+ * @param freeValue Releases the memory a value still in the map owns, may be NULL
+ */
+void freeConcurrentMap(ConcurrentMap *map, void (*freeValue)(void *value)){
+    ConcurrentTable *table = atomic_load_explicit(&map->table, memory_order_relaxed);
+
+    for (size_t i = 0; i <= table->mask; i++){
+        ConcurrentNode *node = atomic_load_explicit(&table->buckets[i], memory_order_relaxed);
+        while (node){
+            ConcurrentNode *next = atomic_load_explicit(&node->next, memory_order_relaxed);
+            if (freeValue)
+                freeValue(node->value);
+            releaseNodeAndKey(node);
+            node = next;
+        }
+    }
+    free(table);
+
+    freeEpochs(&map->epochs); // Retired nodes and arrays, their keys are freed above or with them
+    for (int i = 0; i < CONCURRENT_STRIPES; i++)
+        pthread_mutex_destroy(&map->stripes[i].lock);
+    atomic_store_explicit(&map->size, 0, memory_order_relaxed);
+}
@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "epoch.h"
+
+/**
+ * @brief Initialize a domain with no readers and nothing retired
+ * @param domain The domain
+ */
+void initializeEpochs(EpochDomain *domain){
+    atomic_init(&domain->global, 0);
+    atomic_init(&domain->readerCount, 0);
+    for (int i = 0; i < EPOCH_MAX_READERS; i++)
+        atomic_init(&domain->readers[i].state, 0);
+    pthread_mutex_init(&domain->lock, NULL);
+    for (int i = 0; i < 3; i++)
+        domain->limbo[i] = NULL;
+}
+
+/**
+ * @brief Give a thread its own reader slot, once before it first reads
+ * @param domain The domain
+ * @return The reader slot
+ */
+int registerEpochReader(EpochDomain *domain){
+    int reader = atomic_fetch_add(&domain->readerCount, 1);
+    if (reader >= EPOCH_MAX_READERS){
+        printf("Too many reader threads!");
+        exit(EXIT_FAILURE);
+    }
+    return reader;
+}
+
+/**
+ * @brief Announce that a reader starts to use shared memory
+ * @param domain The domain
+ * @param reader The reader slot of the thread
+ */
+void epochEnter(EpochDomain *domain, int reader){
+    uint_fast64_t epoch = atomic_load_explicit(&domain->global, memory_order_acquire);
+    atomic_store_explicit(&domain->readers[reader].state, epoch*2 + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst); // The announcement is visible before anything is read
+}
+
+/**
+ * @brief Announce that a reader holds no shared memory any more
+ * @param domain The domain
+ * @param reader The reader slot of the thread
+ */
+void epochExit(EpochDomain *domain, int reader){
+    atomic_store_explicit(&domain->readers[reader].state, 0, memory_order_release);
+}
+
+/**
+ * @brief Free a list of retired memory
+ * @param list The list
+ */
+static void releaseRetired(Retired *list){
+    while (list){
+        Retired *next = list->next;
+        list->release(list->item);
+        free(list);
+        list = next;
+    }
+}
+
+/**
+ * @brief Advance the global epoch if every active reader announced it, then free what was retired two
+ * epochs ago. The caller holds the lock
+ * @param domain The domain
+ */
+static void tryAdvance(EpochDomain *domain){
+    uint_fast64_t epoch = atomic_load_explicit(&domain->global, memory_order_relaxed);
+    int readers = atomic_load_explicit(&domain->readerCount, memory_order_acquire);
+
+    atomic_thread_fence(memory_order_seq_cst); // Pairs with the fence of epochEnter
+    for (int i = 0; i < readers && i < EPOCH_MAX_READERS; i++){
+        uint_fast64_t state = atomic_load_explicit(&domain->readers[i].state, memory_order_acquire); // Sees everything a reader did before it left
+        if (state != 0 && state != epoch*2 + 1) // Still inside an older epoch
+            return;
+    }
+
+    atomic_store_explicit(&domain->global, epoch + 1, memory_order_release);
+    Retired *expired = domain->limbo[(epoch + 2) % 3]; // Retired in epoch - 1, every reader started later
+    domain->limbo[(epoch + 2) % 3] = NULL;
+    releaseRetired(expired);
+}
+
+/**
+ * @brief Hand memory that is no longer reachable to the domain, it is released once no reader can hold it
+ * @param domain The domain
+ * @param item The memory
+ * @param release Frees the memory
+ */
+void epochRetire(EpochDomain *domain, void *item, void (*release)(void *item)){
+    Retired *retired = malloc(sizeof(Retired));
+    if (!retired){
+        printf("Memory allocation failed!");
+        exit(EXIT_FAILURE);
+    }
+    retired->item = item;
+    retired->release = release;
+
+    pthread_mutex_lock(&domain->lock);
+    uint_fast64_t epoch = atomic_load_explicit(&domain->global, memory_order_relaxed);
+    retired->next = domain->limbo[epoch % 3];
+    domain->limbo[epoch % 3] = retired;
+    tryAdvance(domain);
+    pthread_mutex_unlock(&domain->lock);
+}
+
+/**
+ * @brief Release everything still retired, no reader may be active
+ * @param domain The domain
+ */
+void freeEpochs(EpochDomain *domain){
+    for (int i = 0; i < 3; i++){
+        releaseRetired(domain->limbo[i]);
+        domain->limbo[i] = NULL;
+    }
+    pthread_mutex_destroy(&domain->lock);
+}
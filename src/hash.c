@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/random.h>
+#include "hash.h"
+
+/*
+ * Keys are hashed 8 bytes at a time with the wyhash construction (public domain, Wang Yi): words are
+ * mixed by 64x64->128 bit multiplications and folded. The seed is chosen at random once per process, so
+ * a third party can not precompute names that collide in our tables.
+ *
+ * Building with -DHASH_CRC32 on a CPU with SSE4.2 switches to the CRC32 instruction, which is faster on
+ * short keys. CRC32 is linear, its collisions can be found whatever the seed is, so this path is meant
+ * for trusted input only.
+ */
+
+#if defined(HASH_CRC32) && defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+static const uint64_t secret[4] = {0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull};
+
+/**
+ * @brief Multiply two words and fold the 128-bit product into 64 bits
+ * @param a The first word
+ * @param b The second word
+ * @return The low half of the product xor the high half
+ */
+static uint64_t mix(uint64_t a, uint64_t b){
+    __uint128_t product = (__uint128_t)a*b;
+    return (uint64_t)product ^ (uint64_t)(product >> 64);
+}
+
+/**
+ * @brief Read 8 bytes in native order, the address does not need to be aligned
+ * @param p The first byte
+ * @return The word
+ */
+static uint64_t read64(const uint8_t *p){
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Read 4 bytes in native order, the address does not need to be aligned
+ * @param p The first byte
+ * @return The word
+ */
+static uint64_t read32(const uint8_t *p){
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+#if defined(HASH_CRC32) && defined(__SSE4_2__)
+
+/**
+ * @brief Hash a byte string with the SSE4.2 CRC32 instruction
+ * @param data The bytes to hash
+ * @param len The number of bytes
+ * @param seed The seed of the hash
+ * @return The 64-bit hash
+ */
+uint64_t hashBytes(const void *data, size_t len, uint64_t seed){
+    const uint8_t *p = data;
+    uint64_t crc = seed;
+
+    for (; len >= 8; len -= 8, p += 8) // Whole words first
+        crc = _mm_crc32_u64(crc, read64(p));
+    for (; len > 0; len--, p++) // Remaining bytes
+        crc = _mm_crc32_u8((uint32_t)crc, *p);
+
+    return mix(crc ^ secret[0], seed ^ secret[1]); // CRC32 is 32 bits wide, spread it over the word
+}
+
+#else
+
+/**
+ * @brief Hash a byte string with wyhash
+ * @param data The bytes to hash
+ * @param len The number of bytes
+ * @param seed The seed of the hash
+ * @return The 64-bit hash
+ */
+uint64_t hashBytes(const void *data, size_t len, uint64_t seed){
+    const uint8_t *p = data;
+    uint64_t a, b;
+
+    seed ^= mix(seed ^ secret[0], secret[1]);
+
+    if (len <= 16){
+        if (len >= 4){ // Two overlapping pairs of 4-byte reads cover the key
+            a = (read32(p) << 32) | read32(p + ((len >> 3) << 2));
+            b = (read32(p + len - 4) << 32) | read32(p + len - 4 - ((len >> 3) << 2));
+        }
+        else if (len > 0){ // First, middle and last byte
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        }
+        else{
+            a = b = 0;
+        }
+    }
+    else{
+        size_t i = len;
+
+        if (i > 48){ // Three independent lanes for long keys
+            uint64_t lane1 = seed, lane2 = seed;
+            do{
+                seed = mix(read64(p) ^ secret[1], read64(p + 8) ^ seed);
+                lane1 = mix(read64(p + 16) ^ secret[2], read64(p + 24) ^ lane1);
+                lane2 = mix(read64(p + 32) ^ secret[3], read64(p + 40) ^ lane2);
+                p += 48;
+                i -= 48;
+            }while (i > 48);
+            seed ^= lane1 ^ lane2;
+        }
+
+        while (i > 16){
+            seed = mix(read64(p) ^ secret[1], read64(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+
+        a = read64(p + i - 16); // Last 16 bytes, may overlap the ones already mixed
+        b = read64(p + i - 8);
+    }
+
+    __uint128_t product = (__uint128_t)(a ^ secret[1]) * (b ^ seed);
+    return mix((uint64_t)product ^ secret[0] ^ len, (uint64_t)(product >> 64) ^ secret[1]);
+}
+
+#endif
+
+/**
+ * @brief Get the seed shared by every hash table of the process, it is drawn at random on the first call
+ * @return The seed
+ */
+uint64_t processHashSeed(void){
+    static uint64_t seed = 0;
+    static int initialized = 0;
+
+    if (!initialized){
+        if (getrandom(&seed, sizeof(seed), 0) != sizeof(seed)){ // No entropy source, fall back to time and pid
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            seed = mix((uint64_t)ts.tv_nsec ^ ((uint64_t)ts.tv_sec << 32), (uint64_t)getpid() ^ secret[2]);
+        }
+        initialized = 1;
+    }
+
+    return seed;
+}
@@ -1,141 +1,368 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include "hashmap.h"
+#include "hash.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * The map is an open-addressing table in the style of a Swiss table. Slots are split into groups of
+ * GROUP_WIDTH and every slot has a one-byte control entry. A full slot stores the low 7 bits of its
+ * key's hash (h2) in the control byte, the remaining bits (h1) pick the first group to probe. One SSE2
+ * compare checks a whole group for h2 candidates, so most lookups touch a single key.
+ *
+ * Growing is incremental. A new table takes the place of map->table and the previous one is kept in
+ * map->old, every write moves the next MIGRATION_STEP_SLOTS slots of old into table and lookups check
+ * both tables until old is empty. No single write pays for moving the whole map.
+ */
 
-#define INITIAL_TABLE_SIZE 101
-#define LOAD_FACTOR_THRESHOLD 0.7
-#define MOD 1000000007
+/**
+ * @brief Build a bitmask of the control bytes in a group that are equal to a value
+ * @param ctrl The first control byte of the group
+ * @param value The control value to look for
+ * @return Bit i is set if ctrl[i] == value
+ */
+static unsigned int groupMatch(const signed char *ctrl, signed char value){
+#ifdef __SSE2__
+    __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+    return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(value)));
+#else
+    unsigned int mask = 0;
+    for (int i = 0; i < GROUP_WIDTH; i++){
+        if (ctrl[i] == value)
+            mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
 
-typedef struct HashNode{
-    char *key; // Key of the node
-    void *value; // Value of the node
-    struct HashNode *next; // Pointer to the next node in the linked list
-}HashNode;
+/**
+ * @brief Build a bitmask of the control bytes in a group that are empty or deleted
+ * @param ctrl The first control byte of the group
+ * @return Bit i is set if ctrl[i] is not a full slot
+ */
+static unsigned int groupMatchFree(const signed char *ctrl){
+#ifdef __SSE2__
+    __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+    return (unsigned int)_mm_movemask_epi8(group); // Free control bytes are the negative ones
+#else
+    unsigned int mask = 0;
+    for (int i = 0; i < GROUP_WIDTH; i++){
+        if (!IS_FULL(ctrl[i]))
+            mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
 
-typedef struct{
-    HashNode **table; // Array of HashNode pointers
-    int capacity; // Maximum capacity of the hashmap
-    int size; // Size of the hashmap
-}HashMap;
+/**
+ * @brief Round a requested capacity up to a power of two that holds at least one group
+ * @param capacity The requested capacity
+ * @return The capacity that will be allocated
+ */
+static int roundCapacity(int capacity){
+    int rounded = GROUP_WIDTH;
+    while (rounded < capacity)
+        rounded *= 2;
+    return rounded;
+}
+
+/**
+ * @brief Allocate an empty table
+ * @param table The table
+ * @param capacity The capacity of the table, rounded up to a power of two
+ * @param slotSize The size of one slot
+ */
+static void allocateTable(HashTable *table, int capacity, size_t slotSize){
+    table->size = 0;
+    table->tombstones = 0;
+    table->slotSize = slotSize;
+    table->capacity = roundCapacity(capacity);
+    table->ctrl = malloc(table->capacity); // One control byte per slot
+    table->slots = malloc(table->capacity * slotSize);
+
+    if (!table->ctrl || !table->slots){
+        printf("Memory allocation failed.");
+        exit(EXIT_FAILURE);
+    }
+
+    memset(table->ctrl, CTRL_EMPTY, table->capacity); // Every slot starts empty
+}
+
+/**
+ * @brief Free the arrays of a table, keys are not freed
+ * @param table The table
+ */
+static void releaseTable(HashTable *table){
+    free(table->ctrl);
+    free(table->slots);
+    table->ctrl = NULL;
+    table->slots = NULL;
+    table->capacity = 0;
+    table->size = 0;
+    table->tombstones = 0;
+}
 
 /**
  * @brief Initialize the hashmap
  * @param map The hashmap to initialize
- * @param capacity The initial capacity of the hashmap
+ * @param capacity The initial capacity of the hashmap, rounded up to a power of two
+ * @param valueSize The size of the value stored inline with every key
  */
-void initializeMap(HashMap *map, int capacity){
+void initializeMap(HashMap *map, int capacity, size_t valueSize){
+    size_t align = sizeof(char *);
+    size_t slotSize = (sizeof(char *) + valueSize + align - 1) / align * align; // Keep every slot pointer aligned
+
+    map->valueSize = valueSize;
+    map->seed = processHashSeed();
     map->size = 0;
-    map->capacity = capacity;
-    map->table = (HashNode **)calloc(capacity, sizeof(HashNode *)); // table contains #capacity HashNode*. And, HashNode*'s will point to HashNode structs
+    map->migrateIndex = 0;
+    map->migrationNanos = 0;
+    map->maxMigrationStepNanos = 0;
+    allocateTable(&map->table, capacity, slotSize);
+    map->old.ctrl = NULL; // No rehash in progress
+    map->old.slots = NULL;
+    map->old.capacity = 0;
+    map->old.size = 0;
+    map->old.tombstones = 0;
+}
 
-    if (!map->table){
-        printf("Memory allocation failed.");
-        exit(EXIT_FAILURE);
+/**
+ * @brief Hash function to calculate the hash value of a key
+ * @param map The hashmap
+ * @param key The key to hash
+ * @return The full hash of the key, the map splits it into a group index and a control byte
+ */
+uint64_t hash(HashMap *map, const char *key){
+    return hashBytes(key, strlen(key), map->seed);
+}
+
+/**
+ * @brief Find the slot that holds a key in one table
+ * @param table The table
+ * @param key The key to find, it does not need to be NUL terminated
+ * @param length The length of the key
+ * @param h The hash of the key
+ * @param freeIndex If not NULL, set to the first empty or deleted slot seen on the way, or -1
+ * @return The index of the slot, or -1 if the key is not in the table
+ */
+static int findSlot(HashTable *table, const char *key, size_t length, uint64_t h, int *freeIndex){
+    int groupMask = table->capacity/GROUP_WIDTH - 1;
+    int group = (h >> 7) & groupMask; // First group to probe
+    signed char h2 = h & 0x7F; // Control byte of the key
+
+    if (freeIndex)
+        *freeIndex = -1;
+
+    // Triangular probing visits every group once since the group count is a power of two
+    for (int step = 1; step <= groupMask+1; step++){
+        int base = group*GROUP_WIDTH;
+        unsigned int candidates = groupMatch(&table->ctrl[base], h2);
+
+        if (freeIndex && *freeIndex == -1){ // Remember where the key would be inserted
+            unsigned int free = groupMatchFree(&table->ctrl[base]);
+            if (free)
+                *freeIndex = base + __builtin_ctz(free);
+        }
+
+        while (candidates){
+            int index = base + __builtin_ctz(candidates);
+            const char *slotKey = SLOT_KEY(table, index);
+            if (strncmp(slotKey, key, length) == 0 && slotKey[length] == '\0') // Stored keys are NUL terminated
+                return index;
+            candidates &= candidates - 1; // Drop the lowest candidate
+        }
+
+        if (groupMatch(&table->ctrl[base], CTRL_EMPTY)) // An empty slot ends every probe sequence
+            return -1;
+
+        group = (group + step) & groupMask;
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Find the first empty or deleted slot on the probe sequence of a hash
+ * @param table The table
+ * @param h The hash of the key that will be inserted
+ * @return The index of the free slot
+ */
+static int findFreeSlot(HashTable *table, uint64_t h){
+    int groupMask = table->capacity/GROUP_WIDTH - 1;
+    int group = (h >> 7) & groupMask;
+
+    for (int step = 1; ; step++){
+        int base = group*GROUP_WIDTH;
+        unsigned int free = groupMatchFree(&table->ctrl[base]);
+
+        if (free)
+            return base + __builtin_ctz(free);
+
+        group = (group + step) & groupMask;
     }
 }
 
 /**
- * @brief Hash function to calculate the index of a key in the hashmap
+ * @brief Read a monotonic clock for the migration metrics
+ * @return The current time in nanoseconds
+ */
+static long long nowNanos(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec*1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * @brief Move up to a number of old slots into the current table
  * @param map The hashmap
- * @param key The key to hash
- * @return The index of the key in the hashmap
+ * @param slots The number of old slots to visit, full or not
  */
-unsigned int hash(HashMap *map, const char *key){
-    unsigned int hash = 0;
-    int p = 1;
-    while (*key){
-        hash = (hash + (*key - 'a' + 1)*p)%MOD;
-        p = (p*31)%MOD; // Move to the next power
-        key++; // Move to next char
+static void migrate(HashMap *map, int slots){
+    if (!map->old.ctrl) // Nothing to move
+        return;
+
+    long long start = nowNanos();
+    HashTable *old = &map->old;
+    int end = map->migrateIndex + slots;
+    if (end > old->capacity)
+        end = old->capacity;
+
+    // Keys are unique, so they can be placed without comparing them again
+    for (int i = map->migrateIndex; i < end; i++){
+        if (!IS_FULL(old->ctrl[i]))
+            continue;
+
+        int index = findFreeSlot(&map->table, hash(map, SLOT_KEY(old, i)));
+        if (map->table.ctrl[index] == CTRL_DELETED) // Reusing a tombstone
+            map->table.tombstones--;
+        map->table.ctrl[index] = old->ctrl[i]; // Control byte only depends on the hash
+        memcpy(SLOT_AT(&map->table, index), SLOT_AT(old, i), old->slotSize); // Key pointer and value move together
+        map->table.size++;
+
+        old->ctrl[i] = CTRL_DELETED; // Lookups must not find the key twice
+        old->size--;
     }
+    map->migrateIndex = end;
+
+    if (map->migrateIndex == old->capacity) // Old table is drained
+        releaseTable(old);
 
-    return hash % map->capacity; // Return the index in mod capacity
+    long long elapsed = nowNanos() - start;
+    map->migrationNanos += elapsed;
+    if (elapsed > map->maxMigrationStepNanos)
+        map->maxMigrationStepNanos = elapsed;
+}
+
+/**
+ * @brief Start moving the map into a new table of the given capacity
+ * @param map The hashmap
+ * @param newCapacity The capacity of the new table
+ */
+static void startMigration(HashMap *map, int newCapacity){
+    if (map->old.ctrl) // A previous rehash is still running, finish it first
+        migrate(map, map->old.capacity);
+
+    map->old = map->table;
+    map->migrateIndex = 0;
+    allocateTable(&map->table, newCapacity, map->old.slotSize);
+}
+
+/**
+ * @brief Make room for one more key in the current table
+ * @param map The hashmap
+ * @return 1 if a new table was started, 0 otherwise
+ */
+static int reserveSlot(HashMap *map){
+    HashTable *table = &map->table;
+    if (table->size + table->tombstones + 1 <= table->capacity*LOAD_FACTOR_THRESHOLD)
+        return 0;
+
+    // If tombstones take most of the room, rebuilding at the same size is enough
+    if (table->tombstones > table->size)
+        startMigration(map, table->capacity);
+    else
+        rehash(map);
+    return 1;
+}
+
+/**
+ * @brief Find the table and slot of a key
+ * @param map The hashmap
+ * @param key The key to find
+ * @param length The length of the key
+ * @param h The hash of the key
+ * @param index Set to the index of the slot
+ * @return The table holding the key, or NULL if the key is not in the map
+ */
+static HashTable *locate(HashMap *map, const char *key, size_t length, uint64_t h, int *index){
+    *index = findSlot(&map->table, key, length, h, NULL);
+    if (*index != -1)
+        return &map->table;
+
+    if (map->old.ctrl){ // Key may not have been moved yet
+        *index = findSlot(&map->old, key, length, h, NULL);
+        if (*index != -1)
+            return &map->old;
+    }
+
+    return NULL;
 }
 
 /**
  * @brief Retrieve the value of a key in the hashmap
  * @param map The hashmap
  * @param key The key to retrieve
- * @return The value(void pointer) of the key in the hashmap, or NULL if not found
+ * @return Pointer to the value stored in the key's slot, or NULL if not found. It stays valid until the next write to the map
  */
 void* get(HashMap *map, const char *key){
+    return getSlice(map, key, strlen(key));
+}
+
+/**
+ * @brief Retrieve the value of a key given as a slice of a larger string
+ * @param map The hashmap
+ * @param key The first character of the key, it does not need to be NUL terminated
+ * @param length The length of the key
+ * @return Pointer to the value stored in the key's slot, or NULL if not found. It stays valid until the next write to the map
+ */
+void* getSlice(HashMap *map, const char *key, size_t length){
     if (!map) // If map does not exists, we can not retrieve anything
         return NULL;
 
-    int index = hash(map, key); // Find the possible index of the key
-    
-    HashNode* node = map->table[index]; // Get the head of the linked list
-
-    // Traverse the linked list to find the key
-    while (node){
-        if (strcmp(node->key, key) == 0){ // If we find a match
-            return node->value;
-        }
-        node = node->next;
-    }
+    int index;
+    HashTable *table = locate(map, key, length, hashBytes(key, length, map->seed), &index);
+    if (!table) // Key is not in the map
+        return NULL;
 
-    return NULL; // If we cant find a match, return NULL
+    return SLOT_VALUE(table, index);
 }
 
 /**
- * @brief Update the value of a key in the hashmap
+ * @brief Update the value of a key in the hashmap, the value is overwritten in place
  * @param map The hashmap
  * @param key The key to update
- * @param value The new value to set
- * @param valueSize The size of the new value
+ * @param value The new value to set, map->valueSize bytes are copied
  */
-void update(HashMap *map, const char *key, void *value, size_t valueSize){
-    if (!map) // map is null
+void update(HashMap *map, const char *key, const void *value){
+    void *slot = get(map, key);
+    if (!slot) // Key is not in the map
         return;
-    
-    int index = hash(map, key); // Find the possible index of the key
-
-    HashNode* node = map->table[index]; // Get the head of the linked list
-
-    // Traverse the linked list to find the key
-    while(node){
-        if (strcmp(node->key, key) == 0){ // Key is found
-            free(node->value); // Remove the previous value
-            node->value = malloc(valueSize); // Allocate necessary size for new value
-            if (node->value == NULL){
-                printf("Memory allocation failed.");
-                return;
-            }
-            memcpy(node->value, value, valueSize); // Copy value to node->value
-            return;
-        }
-        node = node->next;
-    }
 
+    memcpy(slot, value, map->valueSize); // Copy value into the slot
 }
 
 
 /**
- * @brief Rehash the hashmap to a new capacity
+ * @brief Start an incremental rehash into a table of twice the capacity
  * @param map The hashmap to rehash
  */
 void rehash(HashMap *map){
-    int oldCapacity = map->capacity;
-    int newCapacity = oldCapacity*2+1; // New capacity is twice the old capacity + 1
-    HashMap newMap; 
-    initializeMap(&newMap, newCapacity); // Allocate memory for the map of capacity newCapacity
-
-    // For every HashNode* in the old map, rehash it and insert it to the newMap
-    for (int i = 0; i < oldCapacity; i++){
-        HashNode* node = map->table[i]; // Current HashNode
-        while(node){
-            HashNode* nextNode = node->next; // Save nextNode
-            int newIndex = hash(&newMap, node->key); // Hash the key again for newMap
-            node->next = newMap.table[newIndex]; // Insert node to the head of the linked list
-            newMap.table[newIndex] = node; // Set our head pointer to head node
-            node = nextNode;
-        }
-    }
-
-    free(map->table); // Free the memory for the old map
-
-    map->capacity = newCapacity; // Update capacity
-    map->table = newMap.table; // Update table
+    startMigration(map, map->table.capacity*2);
 }
 
 /**
@@ -145,23 +372,45 @@ void rehash(HashMap *map){
  * @return 1 if the key exists, 0 otherwise
  */
 int contains(HashMap *map, const char* key){
+    return get(map, key) != NULL;
+}
 
-    int index = hash(map, key); // Find the possible index of the key
-
-    HashNode *currentNode = map->table[index]; // Get the head of the linked list
-
-    // Traverse the linked list
-    while (currentNode){
-        if (strcmp(currentNode->key, key) == 0)
-            return 1;
-        currentNode = currentNode->next;
+/**
+ * @brief Count the groups a lookup of a key probes before it finds the key, for benchmarks of the hash
+ * @param map The hashmap
+ * @param key The key to look up
+ * @return The number of groups probed in the table that holds the key, 0 if the key is not in the map
+ */
+int probeLength(HashMap *map, const char *key){
+    size_t length = strlen(key);
+    uint64_t h = hashBytes(key, length, map->seed);
+    HashTable *tables[2] = {&map->table, &map->old};
+
+    for (int t = 0; t < 2 && tables[t]->ctrl; t++){
+        HashTable *table = tables[t];
+        int groupMask = table->capacity/GROUP_WIDTH - 1;
+        int group = (h >> 7) & groupMask;
+
+        for (int step = 1; step <= groupMask+1; step++){ // Same walk as findSlot
+            int base = group*GROUP_WIDTH;
+            unsigned int candidates = groupMatch(&table->ctrl[base], h & 0x7F);
+
+            for (; candidates; candidates &= candidates - 1){
+                const char *slotKey = SLOT_KEY(table, base + __builtin_ctz(candidates));
+                if (strcmp(slotKey, key) == 0)
+                    return step;
+            }
+            if (groupMatch(&table->ctrl[base], CTRL_EMPTY))
+                break;
+            group = (group + step) & groupMask;
+        }
     }
 
     return 0;
 }
 
 /**
- * @brief Delete a key from the hashmap
+ * @brief Delete a key from the hashmap, its slot becomes a tombstone
  * @param map The hashmap
  * @param key The key to delete
  */
@@ -169,98 +418,131 @@ void deleteKey(HashMap *map, const char *key){
     if (!map) // If there is no map, do not proceed
         return;
 
-    int index = hash(map, key); // Find the possible index of the key
-    HashNode* node = map->table[index]; // Get the head of the linked list
-    HashNode* prev = NULL; // Pointer to the previous node of node
+    migrate(map, MIGRATION_STEP_SLOTS);
 
-    if(!node) // If there is no node, deletion fails
+    int index;
+    HashTable *table = locate(map, key, strlen(key), hash(map, key), &index);
+    if (!table) // Deletion fails
         return;
 
-    // If the node to delete is the first node
-    if (strcmp(node->key, key) == 0){
-        // Deleting the first node
-        map->table[index] = node->next;
-
-        // Free the allocated memory for key and value
-        free(node->key);
-        free(node->value);
-        free(node);
-
-        map->size--;
-        return;
-    }
-    // If we are here, that means the node to delete is not the first node, so we can proceed further
-    prev = node;
-    node = node->next;
-
-    // Traverse the linked list to find the key
-    while (node){
-        if (strcmp(node->key, key) == 0){
-            prev->next = node->next; // Set prev's next to node's next to detach node
-
-            // Free the allocated memory for key and value
-            free(node->key);
-            free(node->value);
-            free(node);
-
-            map->size--; // Decrement size since we deleted a node
-            return;
-        }
-        prev = node;
-        node = node->next;
-    }
+    free(SLOT_KEY(table, index)); // The value is stored in the slot, only the key was allocated
 
+    // Probe sequences of other keys may pass through this slot, so it can not become empty again
+    table->ctrl[index] = CTRL_DELETED;
+    table->size--;
+    table->tombstones++;
+    map->size--;
 }
 
 /**
- * @brief Insert a key-value pair into the hashmap
+ * @brief Find the value of a key, inserting the key with a zeroed value if it is missing. The key is hashed once
  * @param map The hashmap
- * @param key The key to insert
- * @param value The value(void pointer) to insert
- * @param valueSize The size of the value
+ * @param key The key to find or insert
+ * @param inserted If not NULL, set to 1 if the key was inserted and to 0 if it already existed
+ * @return Pointer to the value stored in the key's slot. It stays valid until the next write to the map
  */
-void insert(HashMap *map, const char *key, void *value, size_t valueSize){
-    if ((float)map->size/map->capacity >= LOAD_FACTOR_THRESHOLD){
-        rehash(map); // If threshold is exceeded, resize the map
-    }
+void* findOrInsert(HashMap *map, const char *key, int *inserted){
+    return findOrInsertSlice(map, key, strlen(key), inserted);
+}
 
-    int index = hash(map, key); // Find the possible index of the key
-    HashNode *currentNode = map->table[index]; // Get the head of the linked list
+/**
+ * @brief Same as findOrInsert for a key given as a slice of a larger string, the map stores a NUL terminated copy
+ * @param map The hashmap
+ * @param key The first character of the key, it does not need to be NUL terminated
+ * @param length The length of the key
+ * @param inserted If not NULL, set to 1 if the key was inserted and to 0 if it already existed
+ * @return Pointer to the value stored in the key's slot. It stays valid until the next write to the map
+ */
+void* findOrInsertSlice(HashMap *map, const char *key, size_t length, int *inserted){
+    migrate(map, MIGRATION_STEP_SLOTS);
 
-    // Traverse the linked list to find the key
-    while (currentNode){
-        if (strcmp(currentNode->key, key) == 0)
-            return; // Already existing key, do not update!
+    uint64_t h = hashBytes(key, length, map->seed);
+    int freeIndex;
+    int index = findSlot(&map->table, key, length, h, &freeIndex);
 
-        currentNode = currentNode->next;
+    if (index != -1){ // Already existing key
+        if (inserted)
+            *inserted = 0;
+        return SLOT_VALUE(&map->table, index);
     }
 
-    // Here currentNode points to NULL, we will insert new key here
-    HashNode *newNode = (HashNode *)malloc(sizeof(HashNode));
-    if (!newNode){
-        printf("Memory allocation failed in method INSERT");
-        exit(EXIT_FAILURE);
+    if (map->old.ctrl){ // Key may not have been moved yet
+        index = findSlot(&map->old, key, length, h, NULL);
+        if (index != -1){
+            if (inserted)
+                *inserted = 0;
+            return SLOT_VALUE(&map->old, index);
+        }
     }
 
-    newNode->key = malloc(strlen(key)+1);  // Allocate memory for the key
-    if (!newNode->key){
-        printf("Memory allocaiton failed in method INSERT/key");
-        exit(EXIT_FAILURE);
-    }
-    strcpy(newNode->key, key); // Copy key to currentNode's key
+    if (inserted)
+        *inserted = 1;
 
+    if (reserveSlot(map)) // The probe sequence changed with the table
+        freeIndex = findFreeSlot(&map->table, h);
 
-    newNode->value = malloc(valueSize); // Allocate valueSize bytes for void pointer value
-    if (!newNode->value){
-        printf("Memory allocation failed in method INSERT/value");
+    HashTable *table = &map->table;
+    index = freeIndex;
+
+    char *newKey = malloc(length+1);  // Allocate memory for the key
+    if (!newKey){
+        printf("Memory allocaiton failed in method INSERT/key");
         exit(EXIT_FAILURE);
     }
-    memcpy(newNode->value, value, valueSize); // Copy value to newNode
+    memcpy(newKey, key, length); // Copy key to the slot's key
+    newKey[length] = '\0';
 
-    // newNode is at the beginning of the linkedlist
-    newNode->next = map->table[index];
-    map->table[index] = newNode;
+    SLOT_KEY(table, index) = newKey;
+    memset(SLOT_VALUE(table, index), 0, map->valueSize); // New values start zeroed
 
+    if (table->ctrl[index] == CTRL_DELETED) // Reusing a tombstone
+        table->tombstones--;
+    table->ctrl[index] = h & 0x7F;
+    table->size++;
     map->size++;
+
+    return SLOT_VALUE(table, index);
+}
+
+/**
+ * @brief Insert a key-value pair into the hashmap
+ * @param map The hashmap
+ * @param key The key to insert
+ * @param value The value to insert, map->valueSize bytes are copied into the slot
+ */
+void insert(HashMap *map, const char *key, const void *value){
+    int inserted;
+    void *slot = findOrInsert(map, key, &inserted);
+
+    if (inserted) // New key, an existing one is not updated
+        memcpy(slot, value, map->valueSize); // Copy value into the slot
 }
 
+/**
+ * @brief Free every key of a table and pass its values to freeValue
+ * @param table The table
+ * @param freeValue Releases the memory a value owns, may be NULL
+ */
+static void freeTableKeys(HashTable *table, void (*freeValue)(void *value)){
+    for (int i = 0; i < table->capacity; i++){
+        if (!IS_FULL(table->ctrl[i]))
+            continue;
+        if (freeValue)
+            freeValue(SLOT_VALUE(table, i));
+        free(SLOT_KEY(table, i));
+    }
+    releaseTable(table);
+}
+
+/**
+ * @brief Free the keys and tables of the hashmap
+ * @param map The hashmap
+ * @param freeValue Releases the memory a value owns, may be NULL
+ */
+void freeMap(HashMap *map, void (*freeValue)(void *value)){
+    if (map->table.ctrl)
+        freeTableKeys(&map->table, freeValue);
+    if (map->old.ctrl) // Rehash was still running
+        freeTableKeys(&map->old, freeValue);
+    map->size = 0;
+}
@@ -1,201 +1,94 @@
 #include "structures.h"
 #include "hashmap.h"
+#include "typed_maps.h"
+#include "symbols.h"
+#include "lexer.h"
+#include "arena.h"
+#include "helper_methods.h"
 
 /**
- * @brief Free the memory allocated for a PairArray
- * @param arr The PairArray to free
+ * @brief Compare two staged pairs by symbol id for qsort
+ * @param pair_ptr_1 The first StagedPair
+ * @param pair_ptr_2 The second StagedPair
+ * @return Negative, zero or positive like strcmp
  */
-void freePairArray(PairArray *arr){
-    if (!arr)
-        return;
-
-    // Traverse throguh pair array and free each pair
-    for (int i = 0; i < arr->size; i++){
-        free(arr->array[i]->key);
-        free(arr->array[i]);
-    }
-
-    free(arr->array);
-    free(arr);
-}
-
-void freePotion(Potion *p) {
-    if (!p) return;
-    if (p->recipe)
-        freePairArray(p->recipe);
-    free(p);
-}
-
-void freeBestiary(Bestiary *b) {
-    if (b == NULL) return;
-
-    if (b->effectivePotions != NULL){
-        for (int i = 0; i < b->potionCount; i++)
-            free(b->effectivePotions[i]);
-        free(b->effectivePotions);
-    }
+static int compareStagedKeys(const void *pair_ptr_1, const void *pair_ptr_2){
+    Symbol key_1 = ((const StagedPair *)pair_ptr_1)->key;
+    Symbol key_2 = ((const StagedPair *)pair_ptr_2)->key;
 
-    if (b->effectiveSigns != NULL){
-        for (int i = 0; i < b->signCount; i++)
-            free(b->effectiveSigns[i]);
-        free(b->effectiveSigns);
-    }
-
-    free(b);
+    return (key_1 > key_2) - (key_1 < key_2);
 }
 
-
 /**
- * @brief Count the total quantity of ingredients or trophies in the hashmap
- * @param map The hashmap to count
- * @return The total quantity of ingredients or trophies
+ * @brief Copy a PairArray out of the arena of a line into a Recipe. The recipe is a single allocation
+ * with its pairs already in formula order, followed by the same pairs folded per ingredient for brew.
+ * It is never changed and is freed with free
+ * @param ingredients The ingredients of the recipe
+ * @return The recipe
  */
-int countQuantity(HashMap *map){
-    int total = 0;
-
-    // Iterate through map
-    for (int i = 0; i < map->capacity; i++){
-        if (!map->table[i]) // If entry is null, pass it
-            continue;
+Recipe* createRecipe(const PairArray *ingredients){
+    int size = ingredients->size;
+    Recipe *recipe = malloc(sizeof(Recipe) + size*sizeof(Pair) + size*sizeof(StagedPair)); // Room for every pair to be distinct
+    if (!recipe){
+        printf("Memory allocation failed!");
+        exit(EXIT_FAILURE);
+    }
 
-        int currentSum = 0;
-        HashNode* currentNode = map->table[i]; // Get the head of the linked list
+    recipe->size = size;
+    memcpy(recipe->pairs, ingredients->array, size*sizeof(Pair));
+    qsort(recipe->pairs, recipe->size, sizeof(Pair), comparePotionFormula); // Sorted once, "What is in" only prints it
 
-        // Iterate through linked list
-        while (currentNode){
-            currentSum += *(int *)currentNode->value; // Add the value
-            currentNode = currentNode->next;
-        }
-        total += currentSum;
+    StagedPair *folded = (StagedPair *)(recipe->pairs + size); // Pairs are 8 bytes, so this stays aligned
+    for (int i = 0; i < size; i++){
+        folded[i].key = recipe->pairs[i].key;
+        folded[i].total = recipe->pairs[i].count;
+        folded[i].largest = recipe->pairs[i].count;
     }
-    return total;
-}
+    qsort(folded, size, sizeof(StagedPair), compareStagedKeys); // Repeated ingredients end up next to each other
 
-
-/**
- * @brief Count the total quantity of potions in the hashmap
- * @param potions The hashmap to count
- * @return The total quantity of potions
- */
-int countPotions(HashMap *potions){
-    int total = 0;
-
-    // Iterate through map
-    for (int i = 0; i < potions->capacity; i++){
-        if (!potions->table[i]) // Entry is null, pass it
-            continue;
-        
-        int currentSum = 0;
-        HashNode *currentNode = potions->table[i]; // Get the head of the linked list
-
-        // Iterate through linked list
-        while (currentNode){
-            Potion *currentPotion = (Potion *)currentNode->value;
-            if (!currentPotion)
-                continue;
-
-            currentSum += currentPotion->potionCount; // Add potion count
-            currentNode = currentNode->next;
+    int count = 0; // Distinct ingredients so far
+    for (int i = 0; i < size; i++){
+        if (count > 0 && folded[count-1].key == folded[i].key){ // Same ingredient as the previous pair
+            folded[count-1].total += folded[i].total;
+            if (folded[i].largest > folded[count-1].largest)
+                folded[count-1].largest = folded[i].largest;
+        }
+        else{
+            folded[count++] = folded[i];
         }
-
-        total += currentSum; // Increment total
     }
 
-    return total;
+    recipe->ingredientCount = count;
+    recipe->ingredients = folded;
+    return recipe;
 }
 
 /**
- * @brief Free the memory allocated for the hashmap
- * @param map The hashmap to free
+ * @brief Free the memory owned by a Potion, the Potion itself lives inside a map slot
+ * @param p The Potion
  */
-void freeHashMap(HashMap *map){
-    if (!map) // Map does not exist
-        return;
-    if (!map->table){ // Table does not exist
-        free(map);
-        return;
-    }
-    
-    // Iterate through map
-    for (int i = 0; i < map->capacity; i++){
-        HashNode *current = map->table[i]; // Get the head of the linked list
-
-        // Iterate through linked list
-        while (current){
-            HashNode *next = current->next; // Save next node
-
-            // Free current node with its inner values
-            free(current->key);
-            free(current->value);
-            free(current);
-
-            current = next; // Proceed to next node
-        }
-    }
-    
-    // Free the table and map itself
-    free(map->table);
-    free(map);
+void freePotion(Potion *p) {
+    if (!p) return;
+    free((void *)p->recipe); // The recipe is one allocation
+    free(p->allowed);
+    freeRenderCache(&p->rendered);
 }
-void freeHashMapPotion(HashMap *map){
-    if (!map) // Map does not exist
-        return;
-    if (!map->table){ // Table does not exist
-        free(map);
-        return;
-    }
-    
-    // Iterate through map
-    for (int i = 0; i < map->capacity; i++){
-        HashNode *current = map->table[i]; // Get the head of the linked list
 
-        // Iterate through linked list
-        while (current){
-            HashNode *next = current->next; // Save next node
-
-            // Free current node with its inner values
-            free(current->key);
-            freePotion((Potion *)current->value);
-            free(current);
+/**
+ * @brief Free the memory owned by a Bestiary, the Bestiary itself lives inside a map slot
+ * @param b The Bestiary
+ */
+void freeBestiary(Bestiary *b) {
+    if (b == NULL) return;
 
-            current = next; // Proceed to next node
-        }
-    }
-    
-    // Free the table and map itself
-    free(map->table);
-    free(map);
+    free(b->effectivePotions); // Entries are symbols, only the arrays are owned
+    free(b->effectiveSigns);
+    free(b->merged);
+    freeSymbolSet(&b->potionSet);
+    freeSymbolSet(&b->signSet);
+    freeRenderCache(&b->rendered);
 }
 
-void freeHashMapMonster(HashMap *map){
-    if (!map) // Map does not exist
-        return;
-    if (!map->table){ // Table does not exist
-        free(map);
-        return;
-    }
-    
-    // Iterate through map
-    for (int i = 0; i < map->capacity; i++){
-        HashNode *current = map->table[i]; // Get the head of the linked list
-
-        // Iterate through linked list
-        while (current){
-            HashNode *next = current->next; // Save next node
-
-            // Free current node with its inner values
-            free(current->key);
-            freeBestiary((Bestiary *)current->value);
-            free(current);
-
-            current = next; // Proceed to next node
-        }
-    }
-    
-    // Free the table and map itself
-    free(map->table);
-    free(map);
-}
 
 /**
  * @brief Check if a character is alphanumeric (A-Z, a-z, space)
@@ -209,59 +102,70 @@ int isAlphaNumeric(char c){
 
 /**
  * @brief Check if a string contains non-alphanumeric characters
- * @param name The string to check
+ * @param name The string to check, it does not need to be NUL terminated
+ * @param length The length of the string
  * @return 1 if the string contains non-alphanumeric characters, 0 otherwise
  */
-int containsNonAlphaNumeric(char *name){
-    if (!name) // If name is null
-        return 0;
-
-    // Iterate until null terminator is reached
-    while (*name != '\0'){
-        if (!isAlphaNumeric(*name)){ // If character is not alpha numeric
+int containsNonAlphaNumeric(const char *name, int length){
+    for (int i = 0; i < length; i++){
+        if (!isAlphaNumeric(name[i])){ // If character is not alpha numeric
             return 1;
         }
-        name++;
     }
     return 0;
 }
 
 /**
  * @brief Check if a string is a valid name
- * @param name The string to check
+ * @param name The string to check, it does not need to be NUL terminated
+ * @param length The length of the string
  * @return 1 if the string is a valid name, 0 otherwise
  */
-int isNameValid(char *name){
-    if (!name || strlen(name) == 0 || containsNonAlphaNumeric(name) || strstr(name, "  "))
-        return 0;  // Invalid name, contains consecutive spaces
+int isNameValid(const char *name, int length){
+    if (!name || length <= 0 || containsNonAlphaNumeric(name, length))
+        return 0;  // Invalid name
+
+    for (int i = 1; i < length; i++){
+        if (name[i] == ' ' && name[i-1] == ' ') // Invalid name, contains consecutive spaces
+            return 0;
+    }
     return 1;  // Valid name
 }
 
 /**
- * @brief Extract the potion name from a string
- * @param potionStart The start of the potion name
- * @param firstWord The first word after the potion name
+ * @brief Check if a token is a single word name
+ * @param line The line of the token
+ * @param token The token
+ * @return 1 if the token is a word made of letters, 0 otherwise
  */
-void extractPotionName(char *potionStart, char *firstWord){
-    char *temp = potionStart; // Potion start address
-    char *firstWhiteSpace = NULL; // First white space after potion name, initially uninitialized
-
-    // Loop until we reach first word after potion name
-    while (temp != firstWord){
-        if (*temp == ' '){ // If we reach a white space, save it and skip adjacent white spaces
-            firstWhiteSpace = temp;
-            temp++;
-            while (*temp == ' '){
-                temp++;
-            }
-        }else{
-            temp++;
-        }
+int isWordName(const char *line, const Token *token){
+    return token->type == TOKEN_WORD && isNameValid(line + token->offset, token->length);
+}
+
+/**
+ * @brief Join a run of tokens into one name. Every token must be a word of letters and consecutive words
+ * must be separated by exactly one space, the name is the span of the line from the first word to the last
+ * @param line The line of the tokens
+ * @param tokens The tokens of the name
+ * @param size The number of tokens
+ * @param name Set to the span of the name
+ * @return 1 if the tokens form a valid name, 0 otherwise
+ */
+int joinName(const char *line, const Token *tokens, int size, Token *name){
+    if (size <= 0) // Names are never empty
+        return 0;
+
+    for (int i = 0; i < size; i++){
+        if (!isWordName(line, &tokens[i]))
+            return 0;
+        if (i > 0 && tokens[i].offset != tokens[i-1].offset + tokens[i-1].length + 1) // More than one space between words
+            return 0;
     }
 
-    // Here firstWhiteSpace is pointing to the first white space after potion name
-    if (firstWhiteSpace)
-        *firstWhiteSpace = '\0';
+    name->type = TOKEN_WORD;
+    name->offset = tokens[0].offset;
+    name->length = tokens[size-1].offset + tokens[size-1].length - tokens[0].offset;
+    return 1;
 }
 
 /**
@@ -286,190 +190,75 @@ int compareStrings(const void *str_ptr_1, const void *str_ptr_2){
  * @return The result of the comparison
  */
 int comparePotionFormula(const void *pair_ptr_1, const void *pair_ptr_2){
-    const Pair *p1 = *(const Pair **)pair_ptr_1;
-    const Pair *p2 = *(const Pair **)pair_ptr_2;
+    const Pair *p1 = (const Pair *)pair_ptr_1;
+    const Pair *p2 = (const Pair *)pair_ptr_2;
 
     if (p1->count != p2->count){
         return p2->count - p1->count;  // TODO: Learn why this order matters
     }
     else{
-        return strcmp(p1->key, p2->key);
-    }
-}
-
-/**
- * @brief Create an array of keys from the hashmap
- * @param map The hashmap
- * @return An array of keys
- */
-char **createArrayOfKeys(HashMap *map){
-    int c = 0;
-    char** array_of_keys = malloc(map->size * sizeof(char*)); // Allocate memory for char pointers that will hold keys
-
-    // Iterate through map
-    for (int i = 0; i < map->capacity; i++){
-        HashNode* current = map->table[i]; // Get the head of the linked list
-
-        // Iterate through linked list 
-        while(current){
-            array_of_keys[c++] = strdup(current->key); // Insert key into array, CAREFUL: strdup initially uses malloc
-            current = current->next;
-        }
-    }
-
-    return array_of_keys;
-}
-
-
-/**
- * @brief Free the array of keys
- * @param array_of_keys The array of keys
- * @param c The number of keys
- */
-void freeArrayOfKeys(char **array_of_keys, int c){
-
-    // Iterate through arrays
-    for (int i = 0; i < c; i++){
-        if (array_of_keys[i]){ // If entry is not null
-            free(array_of_keys[i]); // Free the entry
-        }
-    }
-
-    // Free the array itself
-    free(array_of_keys);
-}
-
-
-/**
- * @brief Check if a string is a valid name. A name is valid if it contains only letters and is not empty.
- * @param token The string to check
- * @return 1 if the string is valid, 0 otherwise 
- */
-int containsOnlyNumbers(char *token){ // Check if a string contains only numbers
-    if (!token) // If token is NULL
-        return 0;
-
-    if (*token == '0')
-        return 0;
-
-    while (*token != '\0'){
-        if (*token < '0' || *token > '9') // If token is not a number
-            return 0;
-        token++;
-    }
-
-    return 1; 
-}
-
-
-/**
- * @brief Find the index of a string in an array of strings.
- * @param tokens The array of strings
- * @param size The size of the array
- * @param key The string to find
- * @return The index of the string in the array, or -1 if not found
- */
-int findIndex(char **tokens, int size, char *key){
-    
-    for (int i = 0; i < size; i++){
-        if (strcmp(tokens[i], key) == 0) // If the string is found
-            return i;
+        return strcmp(symbolName(p1->key), symbolName(p2->key));
     }
-
-    return -1;
 }
 
 /**
- * @brief Check if the pairs are valid. A pair is valid if it contains a number followed by a name.
+ * @brief Check if the pairs are valid. Pairs are a number followed by a name, separated by single commas.
  * 
+ * @param line The line of the tokens
  * @param tokens The array of tokens
  * @param size The size of the array
  * @return 1 if the pairs are valid, 0 otherwise
  */
-int checkPairs(char **tokens, int size){
-    int i = 0;
-    char *currentWord = tokens[i];
-
-    while (containsOnlyNumbers(currentWord)){
-        int num = atoi(currentWord); // Convert string to integer
-        i++; // Move to the next token
+int checkPairs(const char *line, const Token *tokens, int size){
+    if (size <= 0) // Nothing to parse
+        return 0;
 
-        if (i >= size){ // If i exceeds size, we have a wrong structure
+    int i = 0;
+    while (1){
+        if (tokens[i].type != TOKEN_NUMBER || i+1 >= size) // A pair starts with a count
             return 0;
-        }
 
-        currentWord = tokens[i]; // Next word to parse
-        if (strcmp(currentWord, ",") == 0){ // If the next word is a comma we have a wrong structure
+        if (!isWordName(line, &tokens[i+1])) // Followed by a single word name
             return 0;
-        }
 
-        int wordSize = strlen(currentWord); // Get the size of the current word
-
-        if (currentWord[wordSize-1] == ','){ // , is attached to the name
-            currentWord[wordSize-1] = '\0'; // Remove the comma
-        }
-        else if (i+1 < size && strcmp(tokens[i+1], ",") == 0){ // If the next word is a comma
-            i++; // Move to the next token
-        }
-        else{  // (1)Last word of the line or (2)missing comma
-            if (i == size-1 && isNameValid(currentWord) && num > 0){ // (1)
-                return 1;  // Pairs are VALID
-            }
-            return 0; // (2)
-        }
+        i += 2; // Move past the pair
+        if (i == size) // Last pair of the line
+            return 1;
 
-        if (!isNameValid(currentWord) || num <= 0){  // If the current word is not a valid name or the number is not positive
+        if (tokens[i].type != TOKEN_COMMA) // Missing comma
             return 0;
-        }
 
-        i++; // Move to the next token
-        if (i >= size){  // If i exceeds size, we have a wrong structure
+        i++; // Move past the comma
+        if (i == size) // Trailing comma
             return 0;
-        }
-
-        currentWord = tokens[i]; // Next word to parse
     }
-
-    return 0;  // Pairs are INVALID
 }
 
 
 /**
- * @brief construct a PairArray from an array of tokens. A PairArray is an array of pairs, where each pair consists of a number and a name.
+ * @brief construct a PairArray from an array of tokens that passed checkPairs. A PairArray is an array of pairs, where each pair consists of a number and a name.
+ * Everything is taken from the arena, so the array lives until the arena is reset
+ * @param arena The arena of the current line
+ * @param line The line of the tokens
  * @param tokens The array of tokens
  * @param size The size of the array
  * @return A pointer to the PairArray
  */
-PairArray* constructPairArray(char **tokens, int size){
+PairArray* constructPairArray(Arena *arena, const char *line, const Token *tokens, int size){
+    int pairCount = (size+1)/3; // Count, name and comma, the last pair has no comma
 
-    PairArray* pairArray = malloc(sizeof(PairArray)); // Allocate memory for PairArray
+    PairArray* pairArray = arenaAlloc(arena, sizeof(PairArray));
     pairArray->size = 0; // Initialize size to 0
-    pairArray->capacity = 10; // Initialize capacity to 10
-    pairArray->array = malloc(sizeof(Pair*)*pairArray->capacity); // Allocate memory for the array of pairs
+    pairArray->capacity = pairCount; // The number of pairs is known, the array never grows
+    pairArray->array = arenaAlloc(arena, sizeof(Pair)*pairCount); // Pairs are stored in place
 
-    int i = 0;
-    while (i < size){ // While there are tokens to parse
-
-        int count = atoi(tokens[i]); // Convert string to integer
-        i++; // Move to the next token
-        char *ingredientName = tokens[i]; // Get the name of the ingredient
-        i++; // Move to the next token
-
-        while (i < size && strcmp(tokens[i], ",") == 0){ // If the next token is a comma
-            i++; // Move to the next token
-        }
-
-        Pair *newPair = malloc(sizeof(Pair)); // Allocate memory for the new pair
-        newPair->count = count; // Set the count
-        newPair->key = malloc(strlen(ingredientName)+1); // Allocate memory for the key
-        strcpy(newPair->key, ingredientName); // Copy the name to the key
-
-        if (pairArray->size == pairArray->capacity) // If the array is full
-            resizeArray(pairArray); // Resize the array
-
-        pairArray->array[pairArray->size++] = newPair; // Add the new pair to the array
+    for (int i = 0; i < size; i += 3){ // Count, name and comma
+        const Token *ingredientName = &tokens[i+1]; // Get the name of the ingredient
 
+        Pair *newPair = &pairArray->array[pairArray->size++]; // Add the new pair to the array
+        newPair->count = tokens[i].value; // The lexer already converted the count
+        newPair->key = internSymbolSlice(line + ingredientName->offset, ingredientName->length); // Names are interned once, here
     }
 
     return pairArray; // Return the PairArray
-}
\ No newline at end of file
+}
@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "input.h"
+
+/**
+ * @brief Map a command log into memory so its lines can be executed without copying them
+ * @param input The input to open
+ * @param path The path of the file
+ * @return 1 on success, 0 if the file can not be opened or mapped
+ */
+int openMappedInput(MappedInput *input, const char *path){
+    input->data = NULL;
+    input->size = 0;
+    input->offset = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return 0;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1){
+        close(fd);
+        return 0;
+    }
+
+    if (st.st_size > 0){ // mmap rejects empty mappings, an empty file simply has no lines
+        void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED){
+            close(fd);
+            return 0;
+        }
+        madvise(data, st.st_size, MADV_SEQUENTIAL); // Lines are read front to back once
+        input->data = data;
+        input->size = st.st_size;
+    }
+
+    close(fd); // The mapping stays valid without the descriptor
+    return 1;
+}
+
+/**
+ * @brief Get the next line of a mapped input as a view into the mapping, without the newline
+ * @param input The input
+ * @param line Set to the first character of the line
+ * @param length Set to the length of the line
+ * @return 1 if a line was found, 0 at the end of the input
+ */
+int nextMappedLine(MappedInput *input, const char **line, size_t *length){
+    if (input->offset >= input->size)
+        return 0;
+
+    const char *start = input->data + input->offset;
+    const char *newline = memchr(start, '\n', input->size - input->offset);
+    size_t end = newline ? (size_t)(newline - input->data) : input->size; // Last line may lack a newline
+
+    *line = start;
+    *length = end - input->offset;
+    input->offset = newline ? end + 1 : end;
+    return 1;
+}
+
+/**
+ * @brief Unmap a mapped input
+ * @param input The input
+ */
+void closeMappedInput(MappedInput *input){
+    if (input->data)
+        munmap((void *)input->data, input->size);
+    input->data = NULL;
+    input->size = 0;
+    input->offset = 0;
+}
@@ -0,0 +1,759 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "journal.h"
+#include "actions.h"
+#include "snapshot.h"
+#include "input.h"
+#include "hash.h"
+
+#define JOURNAL_MAX_ID (1u << 28) // Ids are symbols of the writer, larger ones mean a damaged record
+
+typedef struct{
+    const unsigned char *data; // Payload of the record being replayed
+    size_t size;
+    size_t offset;
+    Symbol *names; // Symbol of every id a NAME record defined, NO_SYMBOL for the others
+    uint32_t nameCapacity;
+    Inventory *inventory;
+    Arena *scratch;
+    Journal *journal; // Takes the generation and snapshot of every LOAD record
+}JournalReplay;
+
+/**
+ * @brief Write bytes to a file descriptor, retrying on short writes. The journal is useless once a
+ * write fails, so the program stops
+ * @param fd The file descriptor
+ * @param data The bytes
+ * @param length The number of bytes
+ */
+static void writeJournalBytes(int fd, const void *data, size_t length){
+    const char *bytes = data;
+    while (length > 0){
+        ssize_t written = write(fd, bytes, length);
+        if (written <= 0){
+            fprintf(stderr, "Journal write failed\n");
+            exit(EXIT_FAILURE);
+        }
+        bytes += written;
+        length -= written;
+    }
+}
+
+/**
+ * @brief Write the pending records and sync them to the disk as one group
+ * @param journal The journal
+ */
+void commitJournal(Journal *journal){
+    if (journal->used == 0)
+        return;
+
+    writeJournalBytes(journal->fd, journal->pending, journal->used);
+    if (fdatasync(journal->fd) == -1){
+        fprintf(stderr, "Journal sync failed\n");
+        exit(EXIT_FAILURE);
+    }
+    journal->used = 0;
+}
+
+/**
+ * @brief Commit the pending records if there are enough of them or the oldest one waited long enough.
+ * Appending a record calls it, and so does a thread that waits for input with records pending
+ * @param journal The journal
+ */
+void commitJournalIfDue(Journal *journal){
+    if (journal->used == 0) // Nothing pending, nothing waits
+        return;
+    if (journal->used >= JOURNAL_GROUP_BYTES){
+        commitJournal(journal);
+        return;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long long elapsed = (now.tv_sec - journal->pendingSince.tv_sec)*1000LL + (now.tv_nsec - journal->pendingSince.tv_nsec)/1000000;
+    if (elapsed >= JOURNAL_GROUP_MILLISECONDS)
+        commitJournal(journal);
+}
+
+/**
+ * @brief Make room for more bytes in the pending records
+ * @param journal The journal
+ * @param bytes The number of bytes
+ */
+static void reserveJournal(Journal *journal, size_t bytes){
+    if (journal->used + bytes <= journal->capacity)
+        return;
+
+    size_t newCapacity = journal->capacity ? journal->capacity : JOURNAL_GROUP_BYTES;
+    while (newCapacity < journal->used + bytes)
+        newCapacity *= 2;
+
+    char *newPending = realloc(journal->pending, newCapacity);
+    if (!newPending){
+        printf("Memory reallocation failed!");
+        exit(EXIT_FAILURE);
+    }
+    journal->pending = newPending;
+    journal->capacity = newCapacity;
+}
+
+/**
+ * @brief Append an unsigned integer to the record being built, 7 bits per byte, low bits first
+ * @param journal The journal
+ * @param value The integer
+ */
+static void putVarint(Journal *journal, uint64_t value){
+    reserveJournal(journal, 10);
+    while (value >= 0x80){
+        journal->pending[journal->used++] = (char)(value | 0x80);
+        value >>= 7;
+    }
+    journal->pending[journal->used++] = (char)value;
+}
+
+/**
+ * @brief Append raw bytes to the record being built
+ * @param journal The journal
+ * @param data The bytes
+ * @param length The number of bytes
+ */
+static void putBytes(Journal *journal, const void *data, size_t length){
+    reserveJournal(journal, length);
+    memcpy(journal->pending + journal->used, data, length);
+    journal->used += length;
+}
+
+/**
+ * @brief Start a record, its frame is filled in by endRecord
+ * @param journal The journal
+ * @param type The type of the record
+ */
+static void beginRecord(Journal *journal, JournalType type){
+    if (journal->used == 0)
+        clock_gettime(CLOCK_MONOTONIC, &journal->pendingSince);
+
+    reserveJournal(journal, sizeof(JournalFrame));
+    journal->recordStart = journal->used;
+    journal->used += sizeof(JournalFrame);
+    putVarint(journal, type);
+}
+
+/**
+ * @brief Finish the record being built by filling in its frame
+ * @param journal The journal
+ */
+static void endRecord(Journal *journal){
+    const char *payload = journal->pending + journal->recordStart + sizeof(JournalFrame);
+    JournalFrame frame;
+
+    frame.size = journal->used - journal->recordStart - sizeof(JournalFrame);
+    frame.check = (uint32_t)hashBytes(payload, frame.size, JOURNAL_CHECK_SEED);
+    memcpy(journal->pending + journal->recordStart, &frame, sizeof(frame));
+}
+
+/**
+ * @brief Log the name of a symbol unless the journal file already has it, must be called before the
+ * record that uses the symbol is started
+ * @param journal The journal
+ * @param symbol The symbol
+ */
+static void defineName(Journal *journal, Symbol symbol){
+    if ((int)symbol >= journal->namedCapacity){
+        int newCapacity = journal->namedCapacity ? journal->namedCapacity : 256;
+        while (newCapacity <= (int)symbol)
+            newCapacity *= 2;
+
+        unsigned char *newNamed = realloc(journal->named, newCapacity);
+        if (!newNamed){
+            printf("Memory reallocation failed!");
+            exit(EXIT_FAILURE);
+        }
+        memset(newNamed + journal->namedCapacity, 0, newCapacity - journal->namedCapacity);
+        journal->named = newNamed;
+        journal->namedCapacity = newCapacity;
+    }
+    if (journal->named[symbol])
+        return;
+
+    const char *name = symbolName(symbol);
+    size_t length = strlen(name);
+
+    beginRecord(journal, JOURNAL_NAME);
+    putVarint(journal, symbol);
+    putVarint(journal, length);
+    putBytes(journal, name, length);
+    endRecord(journal);
+    journal->named[symbol] = 1;
+}
+
+/**
+ * @brief Log a loot or trade, the trophies that were removed and the ingredients that were added
+ * @param journal The journal
+ * @param trophies The trophies of a trade, NULL for a loot
+ * @param ingredients The ingredients
+ */
+void journalCounters(Journal *journal, const PairArray *trophies, const PairArray *ingredients){
+    int trophyCount = trophies ? trophies->size : 0;
+
+    for (int i = 0; i < trophyCount; i++)
+        defineName(journal, trophies->array[i].key);
+    for (int i = 0; i < ingredients->size; i++)
+        defineName(journal, ingredients->array[i].key);
+
+    beginRecord(journal, JOURNAL_COUNTERS);
+    putVarint(journal, trophyCount);
+    putVarint(journal, ingredients->size);
+    for (int i = 0; i < trophyCount; i++){
+        putVarint(journal, trophies->array[i].key);
+        putVarint(journal, trophies->array[i].count);
+    }
+    for (int i = 0; i < ingredients->size; i++){
+        putVarint(journal, ingredients->array[i].key);
+        putVarint(journal, ingredients->array[i].count);
+    }
+    endRecord(journal);
+    commitJournalIfDue(journal);
+}
+
+/**
+ * @brief Log a streamed loot or trade, the totals of every trophy and ingredient
+ * @param journal The journal
+ * @param trophies The trophies of a trade, NULL for a loot
+ * @param ingredients The ingredients
+ */
+void journalStagedCounters(Journal *journal, const StagedPairs *trophies, const StagedPairs *ingredients){
+    int trophyCount = trophies ? trophies->size : 0;
+
+    for (int i = 0; i < trophyCount; i++)
+        defineName(journal, trophies->pairs[i].key);
+    for (int i = 0; i < ingredients->size; i++)
+        defineName(journal, ingredients->pairs[i].key);
+
+    beginRecord(journal, JOURNAL_COUNTERS);
+    putVarint(journal, trophyCount);
+    putVarint(journal, ingredients->size);
+    for (int i = 0; i < trophyCount; i++){
+        putVarint(journal, trophies->pairs[i].key);
+        putVarint(journal, trophies->pairs[i].total);
+    }
+    for (int i = 0; i < ingredients->size; i++){
+        putVarint(journal, ingredients->pairs[i].key);
+        putVarint(journal, ingredients->pairs[i].total);
+    }
+    endRecord(journal);
+    commitJournalIfDue(journal);
+}
+
+/**
+ * @brief Log the potions a brew created
+ * @param journal The journal
+ * @param potion The potion
+ * @param times The number of potions created
+ */
+void journalBrew(Journal *journal, Symbol potion, int64_t times){
+    defineName(journal, potion);
+    beginRecord(journal, JOURNAL_BREW);
+    putVarint(journal, potion);
+    putVarint(journal, times);
+    endRecord(journal);
+    commitJournalIfDue(journal);
+}
+
+/**
+ * @brief Log a recipe that was learned
+ * @param journal The journal
+ * @param potion The potion
+ * @param ingredients The pairs of the recipe
+ */
+void journalRecipe(Journal *journal, Symbol potion, const PairArray *ingredients){
+    defineName(journal, potion);
+    for (int i = 0; i < ingredients->size; i++)
+        defineName(journal, ingredients->array[i].key);
+
+    beginRecord(journal, JOURNAL_RECIPE);
+    putVarint(journal, potion);
+    putVarint(journal, ingredients->size);
+    for (int i = 0; i < ingredients->size; i++){
+        putVarint(journal, ingredients->array[i].key);
+        putVarint(journal, ingredients->array[i].count);
+    }
+    endRecord(journal);
+    commitJournalIfDue(journal);
+}
+
+/**
+ * @brief Log a record of two symbols
+ * @param journal The journal
+ * @param type The type of the record
+ * @param first The first symbol
+ * @param second The second symbol
+ */
+static void journalPair(Journal *journal, JournalType type, Symbol first, Symbol second){
+    defineName(journal, first);
+    defineName(journal, second);
+    beginRecord(journal, type);
+    putVarint(journal, first);
+    putVarint(journal, second);
+    endRecord(journal);
+    commitJournalIfDue(journal);
+}
+
+/**
+ * @brief Log a sign that was learned to be effective against a monster
+ * @param journal The journal
+ * @param monster The monster
+ * @param sign The sign
+ */
+void journalSign(Journal *journal, Symbol monster, Symbol sign){
+    journalPair(journal, JOURNAL_SIGN, monster, sign);
+}
+
+/**
+ * @brief Log a potion that was learned to be effective against a monster
+ * @param journal The journal
+ * @param monster The monster
+ * @param potion The potion
+ */
+void journalEffective(Journal *journal, Symbol monster, Symbol potion){
+    journalPair(journal, JOURNAL_EFFECTIVE, monster, potion);
+}
+
+/**
+ * @brief Log a monster that Geralt defeated
+ * @param journal The journal
+ * @param monster The monster
+ */
+void journalEncounter(Journal *journal, Symbol monster){
+    defineName(journal, monster);
+    beginRecord(journal, JOURNAL_ENCOUNTER);
+    putVarint(journal, monster);
+    endRecord(journal);
+    commitJournalIfDue(journal);
+}
+
+/**
+ * @brief Read an unsigned integer of the record being replayed
+ * @param replay The replay
+ * @param value Set to the integer
+ * @return 1 on success, 0 if the record ends first or the integer is too long
+ */
+static int readVarint(JournalReplay *replay, uint64_t *value){
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7){
+        if (replay->offset >= replay->size)
+            return 0;
+
+        unsigned char byte = replay->data[replay->offset++];
+        *value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Read an unsigned integer that must fit in an int
+ * @param replay The replay
+ * @param value Set to the integer
+ * @return 1 on success, 0 if the record is damaged
+ */
+static int readCount(JournalReplay *replay, int *value){
+    uint64_t wide;
+    if (!readVarint(replay, &wide) || wide > INT_MAX)
+        return 0;
+    *value = (int)wide;
+    return 1;
+}
+
+/**
+ * @brief Read an id and map it to the symbol its NAME record defined
+ * @param replay The replay
+ * @param symbol Set to the symbol
+ * @return 1 on success, 0 if the id was never defined
+ */
+static int readSymbol(JournalReplay *replay, Symbol *symbol){
+    uint64_t id;
+    if (!readVarint(replay, &id) || id >= replay->nameCapacity || replay->names[id] == NO_SYMBOL)
+        return 0;
+    *symbol = replay->names[id];
+    return 1;
+}
+
+/**
+ * @brief Read a length and take that many bytes of the record
+ * @param replay The replay
+ * @param bytes Set to the bytes
+ * @param length Set to the length
+ * @return 1 on success, 0 if the record is damaged
+ */
+static int readBytes(JournalReplay *replay, const char **bytes, size_t *length){
+    uint64_t wide;
+    if (!readVarint(replay, &wide) || wide > replay->size - replay->offset)
+        return 0;
+    *bytes = (const char *)replay->data + replay->offset;
+    *length = wide;
+    replay->offset += wide;
+    return 1;
+}
+
+/**
+ * @brief Replay a NAME record
+ * @param replay The replay
+ * @return 1 on success, 0 if the record is damaged
+ */
+static int replayName(JournalReplay *replay){
+    uint64_t id;
+    const char *name;
+    size_t length;
+    if (!readVarint(replay, &id) || id >= JOURNAL_MAX_ID || !readBytes(replay, &name, &length))
+        return 0;
+
+    if (id >= replay->nameCapacity){
+        uint32_t newCapacity = replay->nameCapacity ? replay->nameCapacity : 256;
+        while (newCapacity <= id)
+            newCapacity *= 2;
+
+        Symbol *newNames = realloc(replay->names, newCapacity*sizeof(Symbol));
+        if (!newNames){
+            printf("Memory reallocation failed!");
+            exit(EXIT_FAILURE);
+        }
+        for (uint32_t i = replay->nameCapacity; i < newCapacity; i++)
+            newNames[i] = NO_SYMBOL;
+        replay->names = newNames;
+        replay->nameCapacity = newCapacity;
+    }
+    replay->names[id] = internSymbolSlice(name, length); // A later NAME record of the same id replaces it
+    return 1;
+}
+
+/**
+ * @brief Replay a COUNTERS record
+ * @param replay The replay
+ * @return 1 on success, 0 if the record is damaged
+ */
+static int replayCounters(JournalReplay *replay){
+    Inventory *inventory = replay->inventory;
+    int trophyCount, ingredientCount;
+    if (!readCount(replay, &trophyCount) || !readCount(replay, &ingredientCount))
+        return 0;
+
+    for (int i = 0; i < trophyCount + ingredientCount; i++){
+        Symbol key;
+        uint64_t amount;
+        if (!readSymbol(replay, &key) || !readVarint(replay, &amount) || amount > INT64_MAX)
+            return 0;
+
+        if (i < trophyCount)
+            addToCounter(inventory->trophies, key, -(int64_t)amount);
+        else
+            addToCounter(inventory->ingredients, key, (int64_t)amount);
+    }
+    return 1;
+}
+
+/**
+ * @brief Replay a BREW record, the same brew must succeed again
+ * @param replay The replay
+ * @return 1 on success, 0 if the record does not fit the inventory
+ */
+static int replayBrew(JournalReplay *replay){
+    Inventory *inventory = replay->inventory;
+    Symbol potion;
+    uint64_t times;
+    if (!readSymbol(replay, &potion) || !readVarint(replay, &times) || times > INT_MAX)
+        return 0;
+
+    Potion *p = findPotion(inventory->potions, potion);
+    if (!p || !p->recipe)
+        return 0;
+    return brewPotion(inventory->potions, inventory->ingredients, potion, (int64_t)times) == (int64_t)times;
+}
+
+/**
+ * @brief Replay a RECIPE record
+ * @param replay The replay
+ * @return 1 on success, 0 if the record is damaged or the potion already has a recipe
+ */
+static int replayRecipe(JournalReplay *replay){
+    Inventory *inventory = replay->inventory;
+    Symbol potion;
+    int size;
+    if (!readSymbol(replay, &potion) || !readCount(replay, &size) || size == 0 || (size_t)size > replay->size)
+        return 0;
+
+    PairArray recipe = {arenaAlloc(replay->scratch, size*sizeof(Pair)), size, size};
+    for (int i = 0; i < size; i++){
+        if (!readSymbol(replay, &recipe.array[i].key) || !readCount(replay, &recipe.array[i].count) || recipe.array[i].count == 0)
+            return 0;
+    }
+    return addPotionRecipe(inventory->potions, inventory->brewIndex, potion, &recipe);
+}
+
+/**
+ * @brief Replay a LOAD record, its snapshot becomes the one of the last checkpoint
+ * @param replay The replay
+ * @return 1 on success, 0 if the snapshot can not be loaded
+ */
+static int replayLoad(JournalReplay *replay){
+    uint64_t generation;
+    const char *bytes;
+    size_t length;
+    if (!readVarint(replay, &generation) || !readBytes(replay, &bytes, &length))
+        return 0;
+
+    char *path = malloc(length + 1);
+    if (!path){
+        printf("Memory allocation failed!");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(path, bytes, length);
+    path[length] = '\0';
+    if (!loadSnapshot(replay->inventory, path, replay->scratch)){
+        free(path);
+        return 0;
+    }
+
+    free(replay->journal->snapshot);
+    replay->journal->snapshot = path;
+    replay->journal->generation = generation;
+    return 1;
+}
+
+/**
+ * @brief Apply one record to the inventory
+ * @param replay The replay, set to the payload of the record
+ * @return 1 on success, 0 if the record is damaged or does not fit the inventory
+ */
+static int replayRecord(JournalReplay *replay){
+    Inventory *inventory = replay->inventory;
+    uint64_t type;
+    Symbol first, second;
+
+    if (!readVarint(replay, &type))
+        return 0;
+
+    switch (type){
+        case JOURNAL_NAME:
+            return replayName(replay);
+        case JOURNAL_COUNTERS:
+            return replayCounters(replay);
+        case JOURNAL_BREW:
+            return replayBrew(replay);
+        case JOURNAL_RECIPE:
+            return replayRecipe(replay);
+        case JOURNAL_SIGN:
+            return readSymbol(replay, &first) && readSymbol(replay, &second) && addEffectiveSign(inventory->monsters, first, second);
+        case JOURNAL_EFFECTIVE:
+            return readSymbol(replay, &first) && readSymbol(replay, &second) && addEffectivePotion(inventory->monsters, first, second);
+        case JOURNAL_ENCOUNTER:
+            return readSymbol(replay, &first) && defeatMonster(inventory->monsters, inventory->potions, inventory->trophies, first);
+        case JOURNAL_LOAD:
+            return replayLoad(replay);
+    }
+    return 0;
+}
+
+/**
+ * @brief Replay the records of a mapped journal file
+ * @param mapped The journal file, its header is checked
+ * @param journal The journal, takes the checkpoint of the last LOAD record
+ * @param inventory The inventory the records are applied to
+ * @param scratch Arena for temporary structures, reset after every record
+ * @param end Set to the end of the last whole record, the rest of the file is cut short or damaged
+ * @return 1 on success, 0 if the file is not a journal or a whole record does not fit the inventory
+ */
+static int replayJournal(const MappedInput *mapped, Journal *journal, Inventory *inventory, Arena *scratch, size_t *end){
+    JournalHeader header;
+    if (mapped->size < sizeof(header))
+        return 0;
+    memcpy(&header, mapped->data, sizeof(header));
+    if (memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) != 0 || header.version != JOURNAL_VERSION)
+        return 0;
+
+    JournalReplay replay = {NULL, 0, 0, NULL, 0, inventory, scratch, journal};
+    size_t offset = sizeof(header);
+    int valid = 1;
+
+    while (mapped->size - offset >= sizeof(JournalFrame)){
+        JournalFrame frame;
+        memcpy(&frame, mapped->data + offset, sizeof(frame));
+        const unsigned char *payload = (const unsigned char *)mapped->data + offset + sizeof(frame);
+
+        if (frame.size > mapped->size - offset - sizeof(frame) || (uint32_t)hashBytes(payload, frame.size, JOURNAL_CHECK_SEED) != frame.check)
+            break; // Torn write, nothing after it was committed
+
+        replay.data = payload;
+        replay.size = frame.size;
+        replay.offset = 0;
+        valid = replayRecord(&replay) && replay.offset == replay.size;
+        resetArena(scratch);
+        if (!valid)
+            break;
+        offset += sizeof(frame) + frame.size;
+    }
+
+    free(replay.names);
+    *end = offset;
+    return valid;
+}
+
+/**
+ * @brief Open a journal, replaying the records it already has on top of the inventory. A new journal
+ * gets its header, a journal whose last record is cut short is cut before that record
+ * @param journal The journal
+ * @param path The path of the journal file, created if it does not exist
+ * @param inventory The inventory, a loaded snapshot or empty tables
+ * @param scratch Arena for temporary structures
+ * @return 1 on success, 0 if the file can not be used or its records do not fit the inventory
+ */
+int openJournal(Journal *journal, const char *path, Inventory *inventory, Arena *scratch){
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd == -1)
+        return 0;
+
+    MappedInput mapped;
+    if (!openMappedInput(&mapped, path)){
+        close(fd);
+        return 0;
+    }
+
+    journal->generation = 0;
+    journal->snapshot = NULL;
+
+    if (mapped.size == 0){ // New journal
+        JournalHeader header = {JOURNAL_MAGIC, JOURNAL_VERSION, 0};
+        writeJournalBytes(fd, &header, sizeof(header));
+        fdatasync(fd);
+    }
+    else{
+        size_t end;
+        int valid = replayJournal(&mapped, journal, inventory, scratch, &end);
+        if (valid && end < mapped.size && ftruncate(fd, end) == -1)
+            valid = 0;
+        if (!valid){
+            closeMappedInput(&mapped);
+            close(fd);
+            free(journal->snapshot);
+            return 0;
+        }
+    }
+    closeMappedInput(&mapped);
+    lseek(fd, 0, SEEK_END);
+
+    journal->fd = fd;
+    journal->path = strdup(path);
+    journal->pending = NULL;
+    journal->used = 0;
+    journal->capacity = 0;
+    journal->recordStart = 0;
+    journal->named = NULL;
+    journal->namedCapacity = 0;
+    if (!journal->path){
+        printf("Memory allocation failed!");
+        exit(EXIT_FAILURE);
+    }
+    return 1;
+}
+
+/**
+ * @brief Build a path next to the journal
+ * @param journal The journal
+ * @param generation The generation of a checkpoint, the path is JOURNAL.GENERATION.snap, or 0 for JOURNAL.tmp
+ * @return The path, the caller frees it
+ */
+static char* journalSibling(Journal *journal, uint64_t generation){
+    size_t size = strlen(journal->path) + 32;
+    char *path = malloc(size);
+    if (!path){
+        printf("Memory allocation failed!");
+        exit(EXIT_FAILURE);
+    }
+    if (generation)
+        snprintf(path, size, "%s.%llu.snap", journal->path, (unsigned long long)generation);
+    else
+        snprintf(path, size, "%s.tmp", journal->path);
+    return path;
+}
+
+/**
+ * @brief Start the journal over from a new checkpoint. The inventory is saved to a snapshot of the next
+ * generation, then a new journal file that holds one LOAD record of it replaces the old one at once. A crash
+ * before that leaves the old journal with the snapshot it names, which is still there
+ * @param journal The journal
+ * @param inventory The inventory, it holds every change logged so far
+ * @return 1 on success, 0 if the snapshot or the new journal file can not be written, the old journal
+ * is still complete and in use then
+ */
+int checkpointJournal(Journal *journal, Inventory *inventory){
+    uint64_t generation = journal->generation + 1;
+    char *snapshot = journalSibling(journal, generation);
+    if (!saveSnapshot(inventory, snapshot)){
+        free(snapshot);
+        return 0;
+    }
+
+    char *absolute = realpath(snapshot, NULL); // Replay may run in another directory
+    char *temporary = journalSibling(journal, 0);
+    int fd = absolute ? open(temporary, O_RDWR | O_CREAT | O_TRUNC, 0644) : -1;
+    if (fd == -1){
+        remove(snapshot);
+        free(snapshot);
+        free(absolute);
+        free(temporary);
+        return 0;
+    }
+
+    commitJournal(journal); // If the new file can not replace the old one, the old one stays complete
+
+    JournalHeader header = {JOURNAL_MAGIC, JOURNAL_VERSION, 0};
+    beginRecord(journal, JOURNAL_LOAD);
+    putVarint(journal, generation);
+    putVarint(journal, strlen(absolute));
+    putBytes(journal, absolute, strlen(absolute));
+    endRecord(journal);
+
+    writeJournalBytes(fd, &header, sizeof(header));
+    writeJournalBytes(fd, journal->pending, journal->used);
+    journal->used = 0;
+
+    int replaced = fdatasync(fd) == 0 && rename(temporary, journal->path) == 0;
+    if (replaced){
+        close(journal->fd);
+        journal->fd = fd;
+        memset(journal->named, 0, journal->namedCapacity); // The new file starts without names
+
+        if (journal->snapshot) // No journal names it any more
+            remove(journal->snapshot);
+        free(journal->snapshot);
+        journal->snapshot = absolute;
+        journal->generation = generation;
+    }
+    else{
+        close(fd);
+        remove(temporary);
+        remove(snapshot);
+        free(absolute);
+    }
+
+    free(snapshot);
+    free(temporary);
+    return replaced;
+}
+
+/**
+ * @brief Commit the pending records and close the journal
+ * @param journal The journal
+ */
+void closeJournal(Journal *journal){
+    commitJournal(journal);
+    close(journal->fd);
+    free(journal->path);
+    free(journal->pending);
+    free(journal->named);
+    free(journal->snapshot);
+}
@@ -0,0 +1,33 @@
+#include <string.h>
+#include "keywords.h"
+
+#define KEYWORD_CASE(id, text, first, last) \
+    case KEYWORD_HASH(sizeof(text)-1, first, last): \
+        keyword = id; \
+        word = text; \
+        break;
+
+/**
+ * @brief Map a word to its keyword with one switch on the perfect hash and one comparison
+ * @param text The word, it does not need to be NUL terminated
+ * @param length The length of the word
+ * @return The keyword, or KW_NONE if the word is not a keyword
+ */
+Keyword lookupKeyword(const char *text, int length){
+    if (length <= 0)
+        return KW_NONE;
+
+    Keyword keyword;
+    const char *word;
+
+    switch (KEYWORD_HASH(length, (unsigned char)text[0], (unsigned char)text[length-1])){
+        KEYWORDS(KEYWORD_CASE)
+        default:
+            return KW_NONE;
+    }
+
+    // Only the keyword with this hash can match, check that it really does
+    if (strlen(word) != (size_t)length || memcmp(text, word, length) != 0)
+        return KW_NONE;
+    return keyword;
+}
@@ -0,0 +1,75 @@
+#include <limits.h>
+#include "lexer.h"
+
+/**
+ * @brief Classify a run of characters as a number or a word
+ * @param line The line
+ * @param token The token, its offset and length are set, type, value and keyword are filled in
+ */
+static void classifyWord(const char *line, Token *token){
+    const char *text = line + token->offset;
+    long long value = 0;
+
+    token->type = TOKEN_WORD;
+    token->keyword = lookupKeyword(text, token->length);
+    if (text[0] == '0') // Leading zeros are not numbers, neither is 0
+        return;
+
+    for (int i = 0; i < token->length; i++){
+        if (text[i] < '0' || text[i] > '9')
+            return;
+        value = value*10 + (text[i] - '0');
+        if (value > INT_MAX) // Counts are ints, larger numbers are rejected like any other word
+            return;
+    }
+
+    token->type = TOKEN_NUMBER;
+    token->keyword = KW_NONE;
+    token->value = (int)value;
+}
+
+/**
+ * @brief Split a line into typed tokens in a single pass. Tokens are separated by spaces, commas and
+ * question marks are tokens of their own even when they touch a word. The line is not modified and
+ * nothing is allocated, so the lexer can run on any number of lines at once
+ * @param line The line, it does not need to be NUL terminated
+ * @param length The length of the line, lines longer than LONG_LINE_LIMIT never reach the lexer, so offsets
+ * and counts fit in an int
+ * @param tokens The array that receives the tokens, it must have room for length tokens
+ * @return The number of tokens, or -1 if the line has two commas in a row, which no command accepts
+ */
+int lexLine(const char *line, size_t length, Token *tokens){
+    int size = 0;
+    size_t i = 0;
+
+    while (i < length){
+        char c = line[i];
+
+        if (c == ' '){ // Separator
+            i++;
+        }
+        else if (c == ',' || c == '?'){
+            if (c == ',' && i+1 < length && line[i+1] == ',')
+                return -1;
+
+            tokens[size].type = c == ',' ? TOKEN_COMMA : TOKEN_QMARK;
+            tokens[size].offset = i;
+            tokens[size].length = 1;
+            tokens[size].keyword = KW_NONE;
+            size++;
+            i++;
+        }
+        else{
+            size_t start = i;
+            while (i < length && line[i] != ' ' && line[i] != ',' && line[i] != '?')
+                i++;
+
+            tokens[size].offset = start;
+            tokens[size].length = i - start;
+            classifyWord(line, &tokens[size]);
+            size++;
+        }
+    }
+
+    return size;
+}
@@ -0,0 +1,289 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "line_stream.h"
+#include "actions.h"
+#include "helper_methods.h"
+#include "output.h"
+#include "journal.h"
+
+/**
+ * @brief Initialize an assembler with no line
+ * @param assembler The assembler
+ */
+void initializeAssembler(LineAssembler *assembler){
+    assembler->data = NULL;
+    assembler->length = 0;
+    assembler->capacity = 0;
+    assembler->searched = 0;
+    assembler->open = 0;
+    assembler->mode = LINE_WHOLE;
+    assembler->tokens = NULL;
+    assembler->tokenCapacity = 0;
+    initializeStagedPairs(&assembler->ingredients);
+    initializeStagedPairs(&assembler->trophies);
+}
+
+/**
+ * @brief Check if the assembler holds nothing, a line that is complete in the caller's buffer can then
+ * be executed in place without going through the assembler
+ * @param assembler The assembler
+ * @return 1 if no part of a line was fed, 0 otherwise
+ */
+int assemblerIdle(const LineAssembler *assembler){
+    return !assembler->open;
+}
+
+/**
+ * @brief Find the end of the last complete token. Tokens end at a space, a question mark or a comma
+ * that is not followed by another comma, and that comma must be known to decide
+ * @param assembler The assembler
+ * @return The number of bytes that can be lexed now, 0 if no token is complete yet
+ */
+static size_t completePrefix(LineAssembler *assembler){
+    const char *data = assembler->data;
+    size_t length = assembler->length;
+
+    for (size_t i = length; i > assembler->searched; i--){
+        char c = data[i-1];
+        if (c == ' ' || c == '?' || (c == ',' && i < length && data[i] != ','))
+            return i;
+    }
+
+    if (length > 0)
+        assembler->searched = length-1; // The last byte may become a cut once the next byte is known
+    return 0;
+}
+
+/**
+ * @brief Lex the first bytes of the line into the token array of the assembler
+ * @param assembler The assembler
+ * @param length The number of bytes to lex, it must end at a complete token
+ * @return The number of tokens, -1 for two commas in a row
+ */
+static int lexPrefix(LineAssembler *assembler, size_t length){
+    if (length > assembler->tokenCapacity){ // A part never has more tokens than characters
+        assembler->tokenCapacity = length;
+        assembler->tokens = realloc(assembler->tokens, assembler->tokenCapacity*sizeof(Token));
+        if (!assembler->tokens){
+            printf("Memory reallocation failed!");
+            exit(EXIT_FAILURE);
+        }
+    }
+    return lexLine(assembler->data, length, assembler->tokens);
+}
+
+/**
+ * @brief Give up on the current line, it is INVALID whatever follows
+ * @param assembler The assembler
+ */
+static void skipLine(LineAssembler *assembler){
+    assembler->mode = LINE_SKIPPED;
+    assembler->length = 0;
+    clearStagedPairs(&assembler->ingredients);
+    clearStagedPairs(&assembler->trophies);
+}
+
+/**
+ * @brief Advance the pair grammar of a streamed loot or trade by one token. The grammar is the one of the
+ * command table: pairs separated by commas, and for a trade the trophies end at the first "trophy" word
+ * @param assembler The assembler
+ * @param token The token
+ * @return 1 if the line is still valid, 0 otherwise
+ */
+static int consumeToken(LineAssembler *assembler, const Token *token){
+    int trophyPart = assembler->command == KW_TRADES && !assembler->forSeen;
+
+    if (trophyPart && token->type == TOKEN_WORD && token->keyword == KW_TROPHY){ // Ends the trophies, even where a name is expected
+        if (assembler->state != AFTER_PAIR)
+            return 0;
+        assembler->state = EXPECT_FOR;
+        return 1;
+    }
+
+    switch (assembler->state){
+        case EXPECT_COUNT:
+            if (token->type != TOKEN_NUMBER)
+                return 0;
+            assembler->pendingCount = token->value;
+            assembler->state = EXPECT_NAME;
+            return 1;
+
+        case EXPECT_NAME:
+            if (!isWordName(assembler->data, token))
+                return 0;
+            stagePair(trophyPart ? &assembler->trophies : &assembler->ingredients,
+                      internSymbolSlice(assembler->data + token->offset, token->length), assembler->pendingCount);
+            assembler->state = AFTER_PAIR;
+            return 1;
+
+        case AFTER_PAIR:
+            if (token->type != TOKEN_COMMA)
+                return 0;
+            assembler->state = EXPECT_COUNT;
+            return 1;
+
+        case EXPECT_FOR:
+            if (token->type != TOKEN_WORD || token->keyword != KW_FOR)
+                return 0;
+            assembler->forSeen = 1;
+            assembler->state = EXPECT_COUNT;
+            return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Lex and consume the complete tokens of a streamed line, the incomplete last token stays buffered
+ * @param assembler The assembler
+ * @param length The number of bytes to consume, it must end at a complete token
+ * @param first The index of the first token to consume
+ */
+static void consumePrefix(LineAssembler *assembler, size_t length, int first){
+    int size = lexPrefix(assembler, length);
+    if (size == -1){
+        skipLine(assembler);
+        return;
+    }
+
+    for (int i = first; i < size; i++){
+        if (!consumeToken(assembler, &assembler->tokens[i])){
+            skipLine(assembler);
+            return;
+        }
+    }
+
+    memmove(assembler->data, assembler->data + length, assembler->length - length); // Keep the incomplete token
+    assembler->length -= length;
+    assembler->searched = 0;
+}
+
+/**
+ * @brief Decide what to do with a line that outgrew STREAM_THRESHOLD. Loot and trade lines are streamed,
+ * anything else is collected whole
+ * @param assembler The assembler
+ */
+static void chooseMode(LineAssembler *assembler){
+    size_t length = completePrefix(assembler);
+    int size = lexPrefix(assembler, length);
+
+    if (size == -1){ // Two commas in a row, no command accepts the line
+        skipLine(assembler);
+        return;
+    }
+
+    // Both keywords are short, if they are not among the complete tokens the line is not a loot or trade
+    if (size < 2 || assembler->tokens[0].keyword != KW_GERALT || (assembler->tokens[1].keyword != KW_LOOTS && assembler->tokens[1].keyword != KW_TRADES)){
+        assembler->mode = LINE_LONG;
+        return;
+    }
+
+    assembler->mode = LINE_STREAMED;
+    assembler->command = assembler->tokens[1].keyword;
+    assembler->state = EXPECT_COUNT;
+    assembler->forSeen = 0;
+    consumePrefix(assembler, length, 2); // Skip "Geralt loots" or "Geralt trades"
+}
+
+/**
+ * @brief Append a piece of the current line. A line that grows past STREAM_THRESHOLD is either streamed,
+ * so only its last incomplete token is kept, or collected whole. Once more than LONG_LINE_LIMIT bytes are
+ * kept the line is skipped, it is INVALID before its tokens are allocated
+ * @param assembler The assembler
+ * @param piece The bytes, without a new line character
+ * @param length The number of bytes
+ */
+void feedLine(LineAssembler *assembler, const char *piece, size_t length){
+    assembler->open = 1;
+
+    if (assembler->mode == LINE_SKIPPED)
+        return;
+
+    if (assembler->length + length > assembler->capacity){
+        size_t newCapacity = assembler->capacity ? assembler->capacity : 1024;
+        while (newCapacity < assembler->length + length)
+            newCapacity *= 2;
+
+        char *newData = realloc(assembler->data, newCapacity);
+        if (newData == NULL){
+            printf("Memory reallocation failed!");
+            exit(EXIT_FAILURE);
+        }
+        assembler->data = newData;
+        assembler->capacity = newCapacity;
+    }
+    memcpy(assembler->data + assembler->length, piece, length);
+    assembler->length += length;
+
+    if (assembler->length <= STREAM_THRESHOLD)
+        return;
+
+    if (assembler->mode == LINE_WHOLE){
+        chooseMode(assembler);
+    }
+    else if (assembler->mode == LINE_STREAMED){
+        size_t complete = completePrefix(assembler);
+        if (complete > 0)
+            consumePrefix(assembler, complete, 0);
+    }
+
+    if (assembler->length > LONG_LINE_LIMIT) // A long line or a single token too long to hold
+        skipLine(assembler);
+}
+
+/**
+ * @brief End the current line. A streamed line is finished here, its staged pairs are applied at once
+ * when the whole line was valid, otherwise nothing changes and INVALID is printed
+ * @param assembler The assembler
+ * @param inventory The tables a streamed line updates
+ * @param line Set to the collected line when the caller has to execute it
+ * @param length Set to the length of the collected line
+ * @return 1 if the caller has to execute the collected line, 0 if the line was already handled
+ */
+int endLine(LineAssembler *assembler, Inventory *inventory, const char **line, size_t *length){
+    assembler->open = 0;
+    assembler->searched = 0;
+
+    if (assembler->mode == LINE_WHOLE || assembler->mode == LINE_LONG){ // The data stays valid until the next piece is fed
+        *line = assembler->data;
+        *length = assembler->length;
+        assembler->mode = LINE_WHOLE;
+        assembler->length = 0;
+        return 1;
+    }
+
+    if (assembler->mode == LINE_STREAMED)
+        consumePrefix(assembler, assembler->length, 0); // The end of the line completes the last token, this may skip the line
+
+    if (assembler->mode == LINE_STREAMED && assembler->state == AFTER_PAIR && (assembler->command == KW_LOOTS || assembler->forSeen)){
+        if (assembler->command == KW_LOOTS){
+            lootStaged(inventory->ingredients, &assembler->ingredients);
+            if (inventory->journal)
+                journalStagedCounters(inventory->journal, NULL, &assembler->ingredients);
+        }
+        else if (tradeStaged(inventory->ingredients, inventory->trophies, &assembler->ingredients, &assembler->trophies) && inventory->journal){
+            journalStagedCounters(inventory->journal, &assembler->trophies, &assembler->ingredients);
+        }
+    }
+    else{
+        outPrintf("INVALID\n");
+    }
+
+    clearStagedPairs(&assembler->ingredients);
+    clearStagedPairs(&assembler->trophies);
+    assembler->mode = LINE_WHOLE;
+    assembler->length = 0;
+    return 0;
+}
+
+/**
+ * @brief Free the memory of an assembler
+ * @param assembler The assembler
+ */
+void freeAssembler(LineAssembler *assembler){
+    free(assembler->data);
+    free(assembler->tokens);
+    freeStagedPairs(&assembler->ingredients);
+    freeStagedPairs(&assembler->trophies);
+    initializeAssembler(assembler);
+}
@@ -2,618 +2,373 @@
 #include <stdlib.h>
 #include <string.h>
 #include "hashmap.h"
+#include "typed_maps.h"
+#include "symbols.h"
 #include "actions.h"
 #include "structures.h"
 #include "queries.h"
 #include "helper_methods.h"
+#include "render_cache.h"
+#include "output.h"
+#include "lexer.h"
+#include "input.h"
+#include "commands.h"
+#include "line_stream.h"
+#include "arena.h"
+#include "snapshot.h"
+#include "journal.h"
+#include "server.h"
+#include "pipeline.h"
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/stat.h>
+
+Inventory inventory; // Every table the commands work on
+Arena lineArena; // Transient structures of the current line, reset after every line
+Journal journal; // Log of the changes, used when --journal is given
+
+int showStats = 0; // Set by --stats, print cache counters and rehash timings to stderr at exit
+int batch = -1; // Set by --batch or --interactive, otherwise batch mode is used when stdin is not a terminal
+int parserThreads = 0; // Set by --threads, 0 reads, parses and executes on the main thread
+
+Token *tokens = NULL; // Token slices of the current line, reused by every line
+size_t tokenCapacity = 0;
 
-HashMap *ingredients = NULL; // Hashmap to store ingredients
-HashMap *trophies = NULL; // Hashmap to store trophies
-HashMap *potions = NULL; // Hashmap to store potions
-HashMap *monsters = NULL; // Hashmap to store monsters
-
-const int INITIAL_CAPACITY = 13; // Initial hashmap capacity
-
-#define MIN_BREW 3 // Minimum number of words required in BREW action
-#define MIN_LOOT 4 // Minimum number of words required in LOOT action
-#define MIN_TRADE 8 // Minimum number of words required in TRADE action
-#define ENCOUNTER 4 // Minimum number of words required in ENCOUNTER action
-#define MIN_LEARN 8 // Minimum number of words required in LEARN action
-#define MIN_TOTAL 2 // Minimum number of words required in TOTAL query
-#define MIN_WHAT 4 // Minimum number of words required in WHAT IS IN query
-#define MIN_EFFECTIVE 5 // Minimum number of words required in WHAT IS EFFECTIVE query
-#define MIN_TOTAL_POTION 3 // Minimum number of words required in TOTAL POTION query
-#define MIN_TOTAL_TROPHY 3 // Minimum number of words required in TOTAL TROPHY query
-
+/**
+ * @brief Print the query cache counters and the rehash timings of the symbol map to stderr if --stats was given
+ */
+void reportStats(void){
+    if (!showStats)
+        return;
 
+    long long hits, misses;
+    renderCacheStats(&hits, &misses);
+    fprintf(stderr, "query cache: %lld hits, %lld misses\n", hits, misses);
 
+    long long rehashNanos, longestStepNanos;
+    symbolRehashStats(&rehashNanos, &longestStepNanos);
+    fprintf(stderr, "symbol map rehash: %.3f ms total, longest step %.3f ms\n", rehashNanos/1e6, longestStepNanos/1e6);
+}
 
 
 /**
- * @brief Execute the line of input. The function checks the command and calls the appropriate function.
- * @param arr The array of tokens
+ * @brief Execute the line of input. The command table picks the command and its handler runs it.
+ * @param arr The array of tokens produced by lexLine
  * @param size The size of the array
- * @param input The original input line
+ * @param input The original input line, it does not need to be NUL terminated
  */
-void execute_line(char **arr, int size, char *input){
-    // Check if the first word is "Geralt", "Total" or "What" or INVALID
-
-    // If the first word is "Geralt"
-    if (strcmp(arr[0], "Geralt") == 0){
-        // Check if the second word is "loots", "trades", "brews", "learns" or "encounters"
-
-         // If the second word is "loots"
-        if (strcmp(arr[1], "loots") == 0){
-            if (size < MIN_LOOT){ // If command is not given correctly
-                printf("INVALID\n");
-                return;
-            }
-            
-            int prefixCount = 2; // "Geralt loots" prefix size
-            char **ingredientStart = &arr[prefixCount]; // Ingredients start from index 2
-
-            if (!checkPairs(ingredientStart, size-prefixCount)){ // Check if the pairs are valid
-                printf("INVALID\n");
-                return;
-            }
-
-            PairArray *ingredientArray = constructPairArray(ingredientStart, size-prefixCount); // Construct the PairArray
-            loot(ingredients, ingredientArray); // Execute LOOT action
-            freePairArray(ingredientArray); // Free the PairArray
-        }
-
-        // If the second word is "trades"
-        else if (strcmp(arr[1], "trades") == 0){
-            if (size < MIN_TRADE){ // If command is not given correctly
-                printf("INVALID\n");
-                return;
-            }
-            
-            int trophyIndex = -1;
-            // Finds the index of the string "trophy"
-            for (int i = 0; i < size; i++){
-                if (strcmp(arr[i], "trophy") == 0){
-                    trophyIndex = i;
-                    break;
-                }
-            }
-
-            // "trophy" not found or "for" not found
-            if (trophyIndex == -1 || trophyIndex+1 >= size || strcmp(arr[trophyIndex+1], "for") != 0){
-                printf("INVALID\n");
-                return;
-            }
-
-            int prefix = 2;  // "Geralt trades" prefix size
-
-            char **trophyStart = &arr[prefix];  // Trophy array starts from index 2
-            int trophySize = trophyIndex - prefix;
-
-            char **ingredientStart = &arr[trophyIndex+2];  // Ingredient array starts from trophyIndex + 2
-            int ingredientSize = size - (trophyIndex + 2);  // +1 is to skip "for"
-
-            if (!checkPairs(trophyStart, trophySize) || !checkPairs(ingredientStart, ingredientSize)){ // Check if the pairs are valid
-                printf("INVALID\n");
-                return;
-            }
-
-            PairArray *trophyArray = constructPairArray(trophyStart, trophySize);
-            PairArray *ingredientArray = constructPairArray(ingredientStart, ingredientSize);
-
-            trade(ingredients, trophies, ingredientArray, trophyArray); // Execute TRADE action
-
-            // Free pair arrays
-            freePairArray(trophyArray); 
-            freePairArray(ingredientArray);
-
-        }
-
-        // If the second word is "brews"
-        else if (strcmp(arr[1], "brews") == 0){
-            if (size < MIN_BREW){ // If command is not given correctly
-                printf("INVALID\n");
-                return;
-            }
-
-            char *potionName;
-            potionName = strstr(input, "brews") + strlen("brews"); // Points after "brews"
-
-            while (*potionName == ' '){ // Skip whitespaces
-                potionName++;
-            }
-            
-            if (!isNameValid(potionName)){ // If potion name is not valid
-                printf("INVALID\n");
-                return;
-            }
-
-            brew(potions, ingredients, potionName); // Execute BREWS action
-        }
-
-        // If the second word is "learns"
-        else if (strcmp(arr[1], "learns") == 0){
-            if (size < MIN_LEARN){ // If command is not given correctly
-                printf("INVALID\n");
-                return;
-            }
-            
-            char *prefix_consist = "consists";
-            char *prefix_potion = "potion";
-
-
-            int consistsIndex = findIndex(arr, size, prefix_consist); // Index of "consists" in arr
-            int potionIndex = findIndex(arr, size, prefix_potion); // Index of "potion" in arr
-
-            // "consists" token is available
-            if (consistsIndex != -1){
-                if (consistsIndex < 4 || strcmp(arr[consistsIndex-1], "potion") != 0){  // Consists is too early or "potion" does not come before "consists"
-                    printf("INVALID\n");
-                    return;
-                }
-
-                char *potionName = strstr(input, "learns") + strlen("learns"); // Points after "learns"
-
-                while (*potionName == ' '){ // Skip whitespaces
-                    potionName++;
-                }
-
-                char *potionEnd = strstr(input, "potion"); // Points to "potion"
-
-                extractPotionName(potionName, potionEnd); // Extracts potion name
+void execute_line(const Token *arr, int size, const char *input){
+    Command command;
 
-                if (!isNameValid(potionName)){ // Invalid name
-                    printf("INVALID\n");
-                    return;
-                }
-
-                if (size-consistsIndex < 3 || strcmp(arr[consistsIndex+1], "of") != 0){  // After consists at least 3 words must show up and "of" must come after it
-                    printf("INVALID\n");
-                    return;
-                }
-
-                int prefixCount = consistsIndex+2;  // Prefix before ingredient pairs
-                char **ingredientStart = &arr[prefixCount];  // Ingredients start from index prefixCount
-
-                if (!checkPairs(ingredientStart, size-prefixCount)){ // If pairs are invalid
-                    printf("INVALID\n");
-                    return;
-                }
-
-                PairArray *ingredientArray = constructPairArray(ingredientStart, size-prefixCount); // Create ingredient array
-
-                learnPotionRecipe(potions, potionName, ingredientArray); // Execute LEARN RECIPE action
-
-            }
-
-            // "consists" token is not available -> learn sign or potion
-            else{
-                char *monsterName;
-                // Learn sign
-                if (strcmp(arr[3], "sign") == 0 && strcmp(arr[4], "is") == 0 && strcmp(arr[5], "effective") == 0 && strcmp(arr[6], "against") == 0 && size == MIN_LEARN){ // size must be exactly MIN_LEARN after "sign if effective against" 
-                    char *signName = arr[2]; // Name of the sign
-                    monsterName = arr[7]; // Name of the monster
-
-                    if (!isNameValid(signName) || !isNameValid(monsterName)){ // Invalid names
-                        printf("INVALID\n");
-                        return;
-                    }
-                    
-                    learnSign(monsters, monsterName, signName); // Execute LEARN SIGN action
-                }
-
-                // Learn potion
-                else if (potionIndex != -1 && potionIndex+5==size && strcmp(arr[potionIndex+1], "is") == 0 && strcmp(arr[potionIndex+2], "effective") == 0 && strcmp(arr[potionIndex+3], "against") == 0){  // After potion name exactly 5 tokens must come -> "potion is effective against X"
-
-                    char *potionName = strstr(input, "learns") + strlen("learns"); // Points after "learns"
-                    monsterName = arr[size-1]; // Last word is the monster name
-
-                    while (*potionName == ' '){  // Skip whitespaces
-                        potionName++;
-                    }
-
-                    char *potionEnd = strstr(input, "potion"); // Points to "potion"
-                    
-
-                    extractPotionName(potionName, potionEnd); // Extract the potion name
-
-                    if (!isNameValid(potionName) || !isNameValid(monsterName)){ // Invalid name
-                        printf("INVALID\n");
-                        return;
-                    }      
-                    
-                    learnPotion(monsters, monsterName, potionName); // Execute LEARN POTION action
-
-                }
-                
-                // Invalid structure
-                else{
-                    printf("INVALID\n");
-                    return;
-                }
-            }
-        }
-
-        // If the second word is "encounters"
-        else if (strcmp(arr[1], "encounters") == 0){
-            if (size != ENCOUNTER || strcmp(arr[2], "a") != 0){ // Size must be exactly # of expected tokens and "a" must come after
-                printf("INVALID\n");
-                return;
-            }
-
-
-            char *monsterName = arr[size-1]; // Last word is the monster name
-
-            if (!isNameValid(monsterName)){ // Invalid name
-                printf("INVALID\n");
-                return;
-            }
-
-            encounter(monsters, potions, trophies, monsterName); // Execute ENCOUNTER action
-            return;
-        }
-
-        // After "Geralt", an invalid token came
-        else{
-            printf("INVALID\n");
-            return;
-        }
+    if (!parseCommand(input, arr, size, &command)){ // No row of the table matches
+        outPrintf("INVALID\n");
+        return;
     }
 
-    // If the first word is "Total"
-    else if (strcmp(arr[0], "Total") == 0){
-        if(size < 2){ //There is no question with 0 or 1 word.
-            printf("INVALID\n");
-            return;
-        }
-        if(size == 2){ // If size equals to 2, there is 2 options: input is invalid or the question mark is adjoining.     
-            char *word = arr[1];     
-            word[strlen(word)-1] = '\0'; // Make '?' null terminator
-
-            if(strcmp(word, "ingredient") == 0){ // "Total ingredient?"
-                allIngredients(ingredients);
-            }
-            else if(strcmp(word, "potion") == 0){ // "Total potion?"
-                allPotions(potions);
-            }
-            else if(strcmp(word, "trophy") == 0){ // "Total trophy?"
-                allTrophies(trophies);
-            }
-            else{ // Wrong structure
-                printf("INVALID\n");
-                return;
-            }
-        }
-
-        //If the second word is "ingredient"
-        else if(strcmp(arr[1], "ingredient") == 0){ 
-            char *word = arr[2];
-
-            if(size == 3){ // 1: Total ingredient query -or- 2: Specific ingredient query with adjacent question mark -or- 3: INVALID
-                
-                if (strcmp(word, "?") == 0){ // "Total ingredient ?"
-                    allIngredients(ingredients);
-                    return;
-                }
-                else if(word[strlen(word)-1] == '?'){ // "Total ingredient X?"
-                    word[strlen(word)-1] = '\0'; // Remove ? from word 
-
-                    if(!isNameValid(word)){ // Invalid name
-                        printf("INVALID\n");
-                        return;
-                    }
-
-                    specificIngredients(ingredients, word); // Execute SPECIFIC INGREDIENT query
-                    return;
-                }
-                else{ // Wrong structure
-                    printf("INVALID\n");
-                    return;
-                }
-            }
-
-            else if(size == 4){ //Input has to be specific ingredient with disjoint question mark
-                char *qMark = arr[size-1]; // Retrieve question mark
+    executeCommand(&inventory, &command, &lineArena);
+    resetArena(&lineArena); // Nothing built for the line outlives it
+}
 
-                if(!isNameValid(word) || strcmp(qMark, "?") != 0){ // Name is invalid or last word is not question mark
-                    printf("INVALID\n");
-                    return;
-                }
 
-                specificIngredients(ingredients, word); // Execute SPECIFIC INGREDIENTS query
-                return;
-            }
+/**
+ * @brief Show the prompt right away, unless in batch mode. The user may stop typing here for a long time,
+ * so the pending journal records are committed first
+ */
+void prompt(void){
+    if (!batch){
+        if (inventory.journal)
+            commitJournal(inventory.journal);
+        outPrintf(">> ");
+        outFlush();
+    }
+}
 
-            else{ // The size of the input with the second word "ingredient"s size can not be more than 4
-                printf("INVALID\n");
-                return;
-            }
+/**
+ * @brief Lex and execute one complete line
+ * @param current The line, without the new line character and not necessarily NUL terminated
+ * @param length The length of the line
+ * @return 0 if the line is Exit, 1 otherwise
+ */
+int handleLine(const char *current, size_t length){
+    if (length > tokenCapacity){ // A line never has more tokens than characters
+        tokenCapacity = length;
+        tokens = realloc(tokens, tokenCapacity*sizeof(Token));
+        if (!tokens){
+            printf("Memory reallocation failed!");
+            exit(EXIT_FAILURE);
         }
+    }
 
-        // If the second word is "potion"
-        else if(strcmp(arr[1], "potion") == 0){ 
-            if (size < MIN_TOTAL_POTION){ // Wrong structure
-                printf("INVALID\n");
-                return;
-            }
-
-            char *word = arr[2]; // Potion name or question mark
-            char *lastWord = arr[size-1]; // Last word
-
-            // Total potion question with disjoint question mark
-            if(strcmp(word, "?") == 0 && size == 3){
-                allPotions(potions); // Execute ALL POTIONS query
-                return;
-            }
+    int size = lexLine(current, length, tokens); // Size of tokens, -1 for two commas in a row
 
-            // Specific potion with adjoint or disjoint question mark
-            else if(lastWord[strlen(lastWord)-1] == '?'){
-                char *potionName = strstr(input, "potion") + strlen("potion"); // Points after "potion"
-
-                while (*potionName == ' '){ // Skip whitespaces
-                    potionName++;
-                }
-
-                // Last word is a seperate question mark
-                if (strlen(lastWord) == 1){
-                    char *potionEnd = strstr(input, "?"); // Points to "?"
-                    extractPotionName(potionName, potionEnd); // Extract potion name
-                }
-
-                // Last word has a question mark at the end of it
-                else{
-                    input[strlen(input)-1] = '\0'; // Remove '?'
-                }
-                
-                if (!isNameValid(potionName)){ // Name is invalid
-                    printf("INVALID\n");
-                    return;
-                }
-
-                specificPotion(potions, potionName); // Execute SPECIFIC POTION query
-            }
-            else{ // Wrong structure
-                printf("INVALID\n");
-                return;
-            }
-        }
+    if (size == 1 && tokens[0].keyword == KW_EXIT)
+        return 0;
 
-        // If the second word is "trophy"
-        else if(strcmp(arr[1], "trophy") == 0){
-            if (size < MIN_TOTAL_TROPHY){ // Not enough words
-                printf("INVALID\n");
-                return;
-            }
-            char *word = arr[2];
+    // No need to continue, invalid structure
+    if (size < 2){
+        outPrintf("INVALID\n");
+        return 1;
+    }
 
-            if(strcmp(word, "?") == 0 && size == 3){ // "Total trophy ?"
-                allTrophies(trophies); // Execute ALL TROPHIES query
-                return;
-            }
-            if(size == 3){ // It has to be a specific trophy question with adjoint question mark
-                if(word[strlen(word)-1] == '?'){
-                    word[strlen(word)-1] = '\0'; // Make question mark null terminator
-
-                    if(!isNameValid(word)){ // Name is invalid
-                        printf("INVALID\n");
-                        return;
-                    }
-                    specificTrophies(trophies, arr[2]); // Execute SPECIFIC TROPHIES query
-                    return;
-                }
-                else{
-                    printf("INVALID\n");
-                    return;
-                }
-            }
+    execute_line(tokens, size, current); // Execute the line
+    return 1;
+}
 
-            else if(size == 4){ // Input has to be specific trophy with disjoint question mark
-                char *qMark = arr[3]; // Question mark
-                if(!isNameValid(word) || strcmp(qMark, "?") != 0){ // Name is invalid or last word is not question mark
-                    printf("INVALID\n");
-                    return;
-                }
+/**
+ * @brief Execute the lines of a mapped command log. Lines are views into the mapping, only lines longer
+ * than STREAM_THRESHOLD go through the assembler
+ * @param mapped The mapped command log
+ * @param assembler The assembler for long lines
+ * @return 0 if the log ended with Exit, 1 at the end of the log
+ */
+int runMapped(MappedInput *mapped, LineAssembler *assembler){
+    const char *current; // View of the current line, without the new line character
+    size_t length;
 
-                specificTrophies(trophies, word); // Execute SPECIFIC TROPHIES query
-                return;
-            }
+    while (1){
+        prompt();
+        if (!nextMappedLine(mapped, &current, &length))
+            return 1;
 
-            else{ // The size of the input with the second word "trophy"'s size can not be more than 4
-                printf("INVALID\n");
-                return;
-            }  
+        if (length > STREAM_THRESHOLD){
+            for (size_t offset = 0; offset < length; offset += STREAM_THRESHOLD) // Bounded pieces, a streamed line is never held whole
+                feedLine(assembler, current + offset, length - offset < STREAM_THRESHOLD ? length - offset : STREAM_THRESHOLD);
+            if (!endLine(assembler, &inventory, &current, &length))
+                continue;
         }
 
-        // Invalid structure
-        else{
-            printf("INVALID\n");
-            return;
-        }
+        if (!handleLine(current, length))
+            return 0;
     }
+}
 
-    // First word is "What" and second word is "is"
-    else if (strcmp(arr[0], "What") == 0 && strcmp(arr[1], "is") == 0){
-        if (size < MIN_WHAT){ // Not enough words
-            printf("INVALID\n");
-            return;
+/**
+ * @brief Execute the complete lines of a chunk of input. A line that lies inside the chunk is executed in
+ * place, a line that started in an earlier chunk or goes on in a later one goes through the assembler
+ * @param assembler The assembler of the input the chunk belongs to
+ * @param chunk The bytes
+ * @param count The number of bytes
+ * @return 0 if Exit was read, 1 otherwise
+ */
+int executeChunk(LineAssembler *assembler, const char *chunk, size_t count){
+    const char *piece = chunk;
+    const char *end = chunk + count;
+    const char *current;
+    size_t length;
+
+    while (piece < end){
+        const char *newline = memchr(piece, '\n', end - piece);
+        if (!newline){ // The line goes on in the next chunk
+            feedLine(assembler, piece, end - piece);
+            break;
         }
 
-        // Third word is "in"
-        if (strcmp(arr[2], "in") == 0){
-            char *lastWord = arr[size-1];
+        current = piece;
+        length = newline - piece;
+        piece = newline + 1;
 
-            if (lastWord[strlen(lastWord)-1] != '?'){ // Last char of last word must be '?'
-                printf("INVALID\n");
-                return;
+        if (!assemblerIdle(assembler)){ // The line started in an earlier chunk
+            feedLine(assembler, current, length);
+            if (!endLine(assembler, &inventory, &current, &length)){
+                prompt();
+                continue;
             }
-
-            char *potionName = strstr(input, "in") + strlen("in"); // Points after "in"
-
-            while (*potionName == ' '){  // Skip whitespaces
-                potionName++;
-            }
-            
-            // Disjoint question mark
-            if (strcmp(lastWord, "?") == 0 && size != MIN_WHAT){
-                char *potionEnd = strstr(input, "?");
-                extractPotionName(potionName, potionEnd);
-            }
-
-            // Adjoint question mark
-            else{
-                input[strlen(input)-1] = '\0'; // Make last char null terminator
-            }
-
-            if (!isNameValid(potionName)){ // Name is invalid
-                printf("INVALID\n");
-                return;
-            }
-
-            potionFormula(potions, potionName); // Execute POTION FORMULA query
-            return;
-        
         }
 
-        // Third word is "effective" and fourth word is "against"
-        else if (strcmp(arr[2], "effective") == 0 && strcmp(arr[3], "against") == 0){
-            if (size != MIN_EFFECTIVE && size != MIN_EFFECTIVE+1){ // At least 5 words must occur
-                printf("INVALID\n");
-                return;
-            }
-
-            char *lastWord = arr[size-1];
-
-            if (lastWord[strlen(lastWord)-1] != '?'){ // Last char of last word must be '?'
-                printf("INVALID\n");
-                return;
-            }
-
-            char *monsterName;
-
-            // Disjoint question mark
-            if (strcmp(lastWord, "?") == 0 && size == MIN_EFFECTIVE+1){
-                monsterName = arr[size-2]; // 2nd element from last is the monster name
-            }
-            
-            // Adjoint question mark
-            else{
-                lastWord[strlen(lastWord)-1] = '\0';
-                monsterName = lastWord;
-            }
-
-
-            if (!isNameValid(monsterName)){ // Name is invalid
-                printf("INVALID\n");
-                return;
-            }
-
-            potionSignEffectiveness(monsters, monsterName); // Execute POTION SIGN EFFECTIVENESS query
-        }
-        else{
-            printf("INVALID\n");
-            return;
-        }
-    }
-
-    // Invalid structure
-    else{
-        printf("INVALID\n");
-        return;
+        if (!handleLine(current, length))
+            return 0;
+        prompt();
     }
+    return 1;
 }
 
-
 /**
- * @brief Main function. The function reads the input line by line and executes the command.
+ * @brief Execute the last line of an input that ended without a new line character
+ * @param assembler The assembler of the input
+ * @return 0 if the line is Exit, 1 otherwise
  */
-int main(void) {
-    char line[1025]; // Input buffer
-    char lineCopied[1025]; // Copy of input buffer
-    char temp[3000];
-    
-    ingredients = malloc(sizeof(HashMap));  // Pointer to ingredients HashMap
-    initializeMap(ingredients, INITIAL_CAPACITY);
+int finishInput(LineAssembler *assembler){
+    const char *current;
+    size_t length;
+
+    if (assemblerIdle(assembler))
+        return 1;
+    if (endLine(assembler, &inventory, &current, &length) && !handleLine(current, length))
+        return 0;
+    prompt();
+    return 1;
+}
 
-    trophies = malloc(sizeof(HashMap));  // Pointer to trophies HashMap
-    initializeMap(trophies, INITIAL_CAPACITY);
+/**
+ * @brief Wait up to JOURNAL_GROUP_MILLISECONDS for stdin while journal records are pending and commit them
+ * if nothing arrives, so they do not wait for the next read, which may block for good
+ */
+void commitBeforeQuietInput(void){
+    if (!inventory.journal || inventory.journal->used == 0)
+        return;
 
-    potions = malloc(sizeof(HashMap));  // Pointer to potions HashMap
-    initializeMap(potions, INITIAL_CAPACITY);
+    struct pollfd input = {STDIN_FILENO, POLLIN, 0};
+    if (poll(&input, 1, JOURNAL_GROUP_MILLISECONDS) == 0)
+        commitJournal(inventory.journal);
+}
 
-    monsters = malloc(sizeof(HashMap));  // Pointer to monsters HashMap
-    initializeMap(monsters, INITIAL_CAPACITY);
+/**
+ * @brief Execute the lines of stdin. Input is read in chunks of STREAM_THRESHOLD bytes, so only lines that
+ * are held whole are limited, to LONG_LINE_LIMIT bytes
+ * @param assembler The assembler for lines that cross chunks
+ * @return 0 if Exit was read, 1 at the end of the input
+ */
+int runStdin(LineAssembler *assembler){
+    static char chunk[STREAM_THRESHOLD];
 
-    
+    prompt();
     while (1){
-        printf(">> ");
-        fflush(stdout);
-        if (fgets(line, sizeof(line), stdin) == NULL)
+        commitBeforeQuietInput();
+        ssize_t count = read(STDIN_FILENO, chunk, sizeof(chunk));
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0)
             break;
 
-        line[strcspn(line, "\n")] = '\0';  // Discard new line character
+        if (!executeChunk(assembler, chunk, count))
+            return 0;
+    }
+    return finishInput(assembler);
+}
 
-        if (strstr(line, ",,")){
-            printf("INVALID\n");
-            continue;
-        }
 
-        strcpy(lineCopied, line); // Copy line to lineCopied
-        int k = 0;
-        for (int i = 0; i < strlen(lineCopied); i++){
-            if (lineCopied[i] == ','){
-                temp[k++] = ' ';
-                temp[k++] = ',';
-                temp[k++] = ' ';
-            }else{
-                temp[k++] = lineCopied[i];
+/**
+ * @brief Main function. The function reads the input line by line and executes the command.
+ * @param argc The number of arguments
+ * @param argv The arguments, --stats prints the query cache counters and rehash timings at exit, --batch drops the prompt
+ * and flushes the output only when the buffer is full, --interactive forces the prompt, --input FILE
+ * maps a command log and executes its lines in place instead of reading stdin, --load FILE starts from a
+ * snapshot and --save FILE writes one at exit, --journal FILE replays a journal on top of the starting
+ * tables and logs every change to it, --listen PATH serves clients on a Unix domain socket instead of
+ * reading stdin until SIGINT or SIGTERM, --threads N reads and parses ahead of execution on a reader
+ * thread and N parser threads, --snapshot-dir DIR enables Save and Load for file names inside DIR
+ */
+int main(int argc, char **argv) {
+    const char *inputPath = NULL; // Command log given with --input
+    const char *loadPath = NULL; // Snapshot given with --load
+    const char *savePath = NULL; // Snapshot given with --save
+    const char *journalPath = NULL; // Journal given with --journal
+    const char *listenPath = NULL; // Socket given with --listen
+    const char *snapshotDirectory = NULL; // Directory of Save and Load given with --snapshot-dir
+    MappedInput mapped; // Mapping of the command log
+    LineAssembler assembler; // Lines that do not fit in one read or are longer than STREAM_THRESHOLD
+
+    for (int i = 1; i < argc; i++){
+        if (strcmp(argv[i], "--stats") == 0)
+            showStats = 1;
+        else if (strcmp(argv[i], "--batch") == 0)
+            batch = 1;
+        else if (strcmp(argv[i], "--interactive") == 0)
+            batch = 0;
+        else if (strcmp(argv[i], "--input") == 0 && i+1 < argc)
+            inputPath = argv[++i];
+        else if (strcmp(argv[i], "--load") == 0 && i+1 < argc)
+            loadPath = argv[++i];
+        else if (strcmp(argv[i], "--save") == 0 && i+1 < argc)
+            savePath = argv[++i];
+        else if (strcmp(argv[i], "--journal") == 0 && i+1 < argc)
+            journalPath = argv[++i];
+        else if (strcmp(argv[i], "--listen") == 0 && i+1 < argc)
+            listenPath = argv[++i];
+        else if (strcmp(argv[i], "--snapshot-dir") == 0 && i+1 < argc)
+            snapshotDirectory = argv[++i];
+        else if (strcmp(argv[i], "--threads") == 0 && i+1 < argc){
+            parserThreads = atoi(argv[++i]);
+            if (parserThreads < 1 || parserThreads > PIPELINE_MAX_PARSERS){
+                fprintf(stderr, "--threads takes 1 to %d parser threads\n", PIPELINE_MAX_PARSERS);
+                return 2;
             }
         }
-        temp[k] = '\0';
+        else{
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
 
-        char *arr[strlen(line)]; // Array of strings to store tokens
+    if (inputPath && !openMappedInput(&mapped, inputPath)){
+        fprintf(stderr, "Can not read %s\n", inputPath);
+        return 2;
+    }
 
-        int size; // Size of arr
+    struct stat directory;
+    if (snapshotDirectory && (stat(snapshotDirectory, &directory) == -1 || !S_ISDIR(directory.st_mode))){
+        fprintf(stderr, "Can not use snapshot directory %s\n", snapshotDirectory);
+        return 2;
+    }
 
-        // Extract tokens according to " "
-        char *token = strtok(temp, " ");
-        size = 0;
-        while (token != NULL){
-            arr[size] = strdup(token); // Memory is allocated for each token, so at the end we must free it
-            size++;
-            token = strtok(NULL, " ");
+    if (listenPath && parserThreads){
+        fprintf(stderr, "--threads can not be used with --listen\n");
+        return 2;
+    }
+    if (listenPath || parserThreads) // Answers go to the clients, or lines are read long before they run
+        batch = 1;
+    if (batch == -1) // No mode was given, a log file or a pipe on stdin means a replay
+        batch = inputPath || !isatty(STDIN_FILENO);
+    atexit(outFlush); // Whatever is still buffered is written on the way out
+
+    initializeInventory(&inventory);
+    inventory.snapshotDirectory = snapshotDirectory;
+    initializeAssembler(&assembler);
+    initializeArena(&lineArena);
+
+    if (loadPath){
+        if (!loadSnapshot(&inventory, loadPath, &lineArena)){
+            fprintf(stderr, "Can not load snapshot %s\n", loadPath);
+            return 2;
         }
+        resetArena(&lineArena);
+    }
 
-        if (size == 1 && strcmp(arr[0], "Exit") == 0){
-            // Free every HashMap
-            freeHashMap(ingredients);
-            freeHashMap(trophies);
-            freeHashMapPotion(potions);
-            freeHashMapMonster(monsters);
-
-            for (int i = 0; i < size; i++){
-                free(arr[i]);
-            }
-            return 1;
+    if (journalPath){
+        if (!openJournal(&journal, journalPath, &inventory, &lineArena)){ // Replays what happened after the snapshot
+            fprintf(stderr, "Can not replay journal %s\n", journalPath);
+            return 2;
         }
+        inventory.journal = &journal;
+    }
 
-        // No need to continue, invalid structure
-        if (size < 2){
-            printf("INVALID\n");
-            continue;
+    int exitRead; // Exit ends the program with 1
+    if (listenPath){
+        exitRead = 0; // Exit only ends the connection of the client that sent it
+        if (!runServer(listenPath, &inventory, executeChunk, finishInput)){
+            fprintf(stderr, "Can not listen on %s\n", listenPath);
+            exitRead = 2;
         }
+    }
+    else if (parserThreads){
+        exitRead = !runPipeline(inputPath ? &mapped : NULL, parserThreads, &inventory, &lineArena, &assembler, handleLine);
+    }
+    else{
+        exitRead = inputPath ? !runMapped(&mapped, &assembler) : !runStdin(&assembler);
+    }
 
-        execute_line(arr, size, line); // Execute the line
-
-        // Free allocated memory for arr
-        for (int i = 0; i < size; i++){
-            free(arr[i]);
-        }
+    if (savePath && !saveSnapshot(&inventory, savePath)){
+        fprintf(stderr, "Can not save snapshot %s\n", savePath);
+        exitRead = 2;
     }
+    else if (savePath && journalPath && !checkpointJournal(&journal, &inventory)){
+        fprintf(stderr, "Can not checkpoint journal %s\n", journalPath);
+        exitRead = 2;
+    }
+    if (journalPath)
+        closeJournal(&journal);
+
+    // Free every table
+    freeInventory(&inventory);
+    freeSymbols();
+    reportStats();
 
-    // Free every HashMap
-    freeHashMap(ingredients);
-    freeHashMap(trophies);
-    freeHashMapPotion(potions);
-    freeHashMapMonster(monsters);
+    freeAssembler(&assembler);
+    freeArena(&lineArena);
+    free(tokens);
+    if (inputPath)
+        closeMappedInput(&mapped);
 
-    return 0;
+    return exitRead;
 }
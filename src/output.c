@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include "output.h"
+
+/*
+ * Every answer of the program goes through one buffer that is written to stdout when it fills up,
+ * when outFlush is called and at exit. Interactive mode flushes after each prompt, batch mode never
+ * flushes on its own, so a replay costs one write per OUTPUT_BUFFER_SIZE bytes. In server mode the
+ * answers of a line are redirected to the buffer of the client that sent it.
+ */
+
+static char buffer[OUTPUT_BUFFER_SIZE];
+static size_t used = 0; // Bytes waiting in buffer
+static OutputBuffer *target = NULL; // Set by outRedirect, answers go there instead of stdout
+
+/**
+ * @brief Send every answer to a growable buffer instead of stdout, or back to stdout
+ * @param redirect The buffer, NULL for stdout
+ */
+void outRedirect(OutputBuffer *redirect){
+    target = redirect;
+}
+
+/**
+ * @brief Make room for more bytes at the end of the redirect buffer
+ * @param bytes The number of bytes
+ */
+static void reserveTarget(size_t bytes){
+    if (target->length + bytes <= target->capacity)
+        return;
+
+    size_t newCapacity = target->capacity ? target->capacity : 4096;
+    while (newCapacity < target->length + bytes)
+        newCapacity *= 2;
+
+    char *newData = realloc(target->data, newCapacity);
+    if (!newData){
+        printf("Memory reallocation failed!");
+        exit(EXIT_FAILURE);
+    }
+    target->data = newData;
+    target->capacity = newCapacity;
+}
+
+/**
+ * @brief Write bytes to the stdout file descriptor, retrying on short writes
+ * @param data The bytes
+ * @param length The number of bytes
+ */
+static void writeAll(const char *data, size_t length){
+    while (length > 0){
+        ssize_t written = write(STDOUT_FILENO, data, length);
+        if (written <= 0) // stdout is gone, nothing we can do
+            return;
+        data += written;
+        length -= written;
+    }
+}
+
+/**
+ * @brief Write the buffered output to stdout
+ */
+void outFlush(void){
+    writeAll(buffer, used);
+    used = 0;
+}
+
+/**
+ * @brief Append bytes to the output
+ * @param data The bytes
+ * @param length The number of bytes
+ */
+void outWrite(const char *data, size_t length){
+    if (target){
+        reserveTarget(length);
+        memcpy(target->data + target->length, data, length);
+        target->length += length;
+        return;
+    }
+
+    if (used + length > OUTPUT_BUFFER_SIZE){ // Does not fit behind the buffered bytes
+        outFlush();
+        if (length > OUTPUT_BUFFER_SIZE){ // Larger than the whole buffer, bypass it
+            writeAll(data, length);
+            return;
+        }
+    }
+
+    memcpy(buffer + used, data, length);
+    used += length;
+}
+
+/**
+ * @brief Append formatted text to the output
+ * @param format The printf format
+ */
+void outPrintf(const char *format, ...){
+    va_list args;
+
+    if (target){
+        va_start(args, format);
+        int needed = vsnprintf(NULL, 0, format, args);
+        va_end(args);
+
+        reserveTarget(needed + 1); // vsnprintf writes the terminator too
+        va_start(args, format);
+        vsnprintf(target->data + target->length, needed + 1, format, args);
+        va_end(args);
+        target->length += needed;
+        return;
+    }
+
+    va_start(args, format);
+    int needed = vsnprintf(buffer + used, OUTPUT_BUFFER_SIZE - used, format, args); // Format in place if it fits
+    va_end(args);
+
+    if (used + needed < OUTPUT_BUFFER_SIZE){ // vsnprintf needs room for the terminator too
+        used += needed;
+        return;
+    }
+
+    char *text = malloc(needed + 1); // Format aside, outWrite flushes and places it
+    if (!text){
+        printf("Memory allocation failed!");
+        exit(EXIT_FAILURE);
+    }
+
+    va_start(args, format);
+    vsnprintf(text, needed + 1, format, args);
+    va_end(args);
+
+    outWrite(text, needed);
+    free(text);
+}
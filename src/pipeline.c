@@ -0,0 +1,555 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include "pipeline.h"
+#include "output.h"
+#include "symbols.h"
+#include "journal.h"
+
+#define PIPELINE_NAP_NANOSECONDS 50000 // Sleep of a thread that waited PIPELINE_SPINS times without progress
+
+/**
+ * @brief Wait a little before a queue is polled again. The first polls only yield the processor, a stage
+ * that keeps waiting, like the executor while stdin is quiet, sleeps so it does not burn a core
+ * @param spins Polls without progress so far, updated
+ */
+static void backOff(int *spins){
+    if (++*spins < PIPELINE_SPINS){
+        sched_yield();
+        return;
+    }
+    struct timespec nap = {0, PIPELINE_NAP_NANOSECONDS};
+    nanosleep(&nap, NULL);
+}
+
+/**
+ * @brief Check if Exit was executed and every stage must end
+ * @param pipeline The pipeline
+ * @return 1 if the stages must end, 0 otherwise
+ */
+static int stopRequested(Pipeline *pipeline){
+    return atomic_load_explicit(&pipeline->stopping, memory_order_relaxed);
+}
+
+/**
+ * @brief Push an item, waiting while the queue is full
+ * @param pipeline The pipeline
+ * @param ring The queue
+ * @param item The item
+ * @return 1 if the item was pushed, 0 if the pipeline stopped first
+ */
+static int waitPush(Pipeline *pipeline, Ring *ring, void *item){
+    int spins = 0;
+    while (!ringPush(ring, item)){
+        if (stopRequested(pipeline))
+            return 0;
+        backOff(&spins);
+    }
+    return 1;
+}
+
+/**
+ * @brief Pop an item, waiting while the queue is empty
+ * @param pipeline The pipeline
+ * @param ring The queue
+ * @param item Receives the item
+ * @return 1 if an item was popped, 0 if the pipeline stopped first
+ */
+static int waitPop(Pipeline *pipeline, Ring *ring, void **item){
+    int spins = 0;
+    while (!ringPop(ring, item)){
+        if (stopRequested(pipeline))
+            return 0;
+        backOff(&spins);
+    }
+    return 1;
+}
+
+/**
+ * @brief Pop the next parsed batch on the executor, waiting while the queue is empty. The input may stay
+ * quiet for long, so pending journal records are committed once they are due while it waits
+ * @param pipeline The pipeline
+ * @param ring The queue
+ * @param item Receives the batch
+ * @param journal The journal of the inventory, NULL without one
+ * @return 1 if an item was popped, 0 if the pipeline stopped first
+ */
+static int waitParsed(Pipeline *pipeline, Ring *ring, void **item, Journal *journal){
+    int spins = 0;
+    while (!ringPop(ring, item)){
+        if (stopRequested(pipeline))
+            return 0;
+        if (journal)
+            commitJournalIfDue(journal);
+        backOff(&spins);
+    }
+    return 1;
+}
+
+/**
+ * @brief Append a record to a batch
+ * @param batch The batch
+ * @param kind The kind of the record
+ * @param line The line or piece
+ * @param length The length of the line or piece
+ */
+static void addRecord(Batch *batch, RecordKind kind, const char *line, size_t length){
+    if (batch->count == batch->capacity){
+        int newCapacity = batch->capacity ? batch->capacity*2 : PIPELINE_BATCH_LINES;
+        LineRecord *newRecords = realloc(batch->records, newCapacity*sizeof(LineRecord));
+        if (!newRecords){
+            printf("Memory reallocation failed!");
+            exit(EXIT_FAILURE);
+        }
+        batch->records = newRecords;
+        batch->capacity = newCapacity;
+    }
+
+    LineRecord *record = &batch->records[batch->count++];
+    record->kind = kind;
+    record->line = line;
+    record->length = length;
+}
+
+/**
+ * @brief Append a long line, or the part of it that is read so far, as pieces of at most STREAM_THRESHOLD
+ * bytes, the same pieces runMapped feeds to the assembler
+ * @param batch The batch
+ * @param line The bytes
+ * @param length The number of bytes
+ * @param last 1 if the bytes end the line
+ */
+static void addPieces(Batch *batch, const char *line, size_t length, int last){
+    do{
+        size_t piece = length < STREAM_THRESHOLD ? length : STREAM_THRESHOLD;
+        addRecord(batch, last && piece == length ? RECORD_LAST_PIECE : RECORD_PIECE, line, piece);
+        line += piece;
+        length -= piece;
+    }while (length > 0);
+}
+
+/**
+ * @brief Append a complete line, a long one is left to the assembler of the executor
+ * @param batch The batch
+ * @param line The line, without the new line character
+ * @param length The length of the line
+ */
+static void addLine(Batch *batch, const char *line, size_t length){
+    if (length > STREAM_THRESHOLD)
+        addPieces(batch, line, length, 1);
+    else
+        addRecord(batch, RECORD_LINE, line, length);
+}
+
+/**
+ * @brief Get an empty batch from the ones the executor is done with
+ * @param pipeline The pipeline
+ * @return The batch, NULL if the pipeline stopped first
+ */
+static Batch* takeBatch(Pipeline *pipeline){
+    void *item;
+    if (!waitPop(pipeline, &pipeline->freeBatches, &item))
+        return NULL;
+
+    Batch *batch = item;
+    batch->count = 0;
+    batch->tokenCount = 0;
+    return batch;
+}
+
+/**
+ * @brief Hand a batch to the next parser in turn
+ * @param pipeline The pipeline
+ * @param batch The batch, NULL for the end of the input
+ * @param next Number of batches handed on so far, updated
+ * @return 1 if the batch was handed on, 0 if the pipeline stopped first
+ */
+static int sendBatch(Pipeline *pipeline, Batch *batch, int *next){
+    ParserStage *stage = &pipeline->parsers[*next % pipeline->parserCount];
+    if (!waitPush(pipeline, &stage->batches, batch))
+        return 0;
+    (*next)++;
+    return 1;
+}
+
+/**
+ * @brief Tell every parser that the input ended, each passes it on after its last batch
+ * @param pipeline The pipeline
+ * @param next Number of batches handed on so far
+ */
+static void endBatches(Pipeline *pipeline, int next){
+    for (int i = 0; i < pipeline->parserCount; i++){
+        if (!sendBatch(pipeline, NULL, &next))
+            return;
+    }
+}
+
+/**
+ * @brief Cut a mapped input into batches. Lines are views into the mapping
+ * @param pipeline The pipeline
+ */
+static void readMapped(Pipeline *pipeline){
+    const char *line;
+    size_t length;
+    size_t bytes = 0; // Bytes of the lines of the current batch
+    int next = 0;
+    Batch *batch = NULL;
+
+    while (nextMappedLine(pipeline->mapped, &line, &length)){
+        if (!batch && !(batch = takeBatch(pipeline)))
+            return;
+
+        addLine(batch, line, length);
+        bytes += length;
+        if (batch->count >= PIPELINE_BATCH_LINES || bytes >= PIPELINE_BATCH_BYTES){
+            if (!sendBatch(pipeline, batch, &next))
+                return;
+            batch = NULL;
+            bytes = 0;
+        }
+    }
+
+    if (batch && !sendBatch(pipeline, batch, &next))
+        return;
+    endBatches(pipeline, next);
+}
+
+/**
+ * @brief Read from stdin, unless the pipeline stops while the reader waits for input
+ * @param pipeline The pipeline
+ * @param buffer Receives the bytes
+ * @param size The most bytes to read
+ * @return The number of bytes, 0 at the end of the input or on an error, -1 if the pipeline stopped
+ */
+static ssize_t readStdin(Pipeline *pipeline, char *buffer, size_t size){
+    struct pollfd sources[2] = {{STDIN_FILENO, POLLIN, 0}, {pipeline->wake[0], POLLIN, 0}};
+
+    while (1){
+        if (poll(sources, 2, -1) == -1){
+            if (errno == EINTR)
+                continue;
+            return 0;
+        }
+        if (sources[1].revents)
+            return -1;
+
+        ssize_t count = read(STDIN_FILENO, buffer, size);
+        if (count < 0 && errno == EINTR)
+            continue;
+        return count < 0 ? 0 : count; // An error ends the input, like in runStdin
+    }
+}
+
+/**
+ * @brief Cut stdin into batches, one read per batch. Every read lands in the text of its batch, the start
+ * of a line that goes on in the next read is carried over to the next batch
+ * @param pipeline The pipeline
+ */
+static void readStream(Pipeline *pipeline){
+    char *carry = malloc(STREAM_THRESHOLD); // Start of the last line of a read, never longer than STREAM_THRESHOLD
+    size_t carried = 0;
+    int streaming = 0; // A long line is being handed on in pieces
+    int next = 0;
+
+    if (!carry){
+        printf("Memory allocation failed!");
+        exit(EXIT_FAILURE);
+    }
+
+    while (1){
+        Batch *batch = takeBatch(pipeline);
+        if (!batch)
+            break;
+
+        memcpy(batch->text, carry, carried);
+        size_t used = carried;
+        carried = 0;
+
+        ssize_t count = readStdin(pipeline, batch->text + used, STREAM_THRESHOLD);
+        if (count < 0)
+            break;
+        if (count == 0){ // The last line may lack a new line character
+            if (streaming)
+                addPieces(batch, batch->text, 0, 1);
+            else if (used > 0)
+                addLine(batch, batch->text, used);
+            if (sendBatch(pipeline, batch, &next))
+                endBatches(pipeline, next);
+            break;
+        }
+
+        const char *piece = batch->text;
+        const char *end = batch->text + used + count;
+        const char *newline;
+
+        if (streaming){ // Nothing was carried, the read goes on with the long line
+            newline = memchr(piece, '\n', end - piece);
+            addPieces(batch, piece, (newline ? newline : end) - piece, newline != NULL);
+            piece = newline ? newline + 1 : end;
+            streaming = !newline;
+        }
+
+        while (piece < end && (newline = memchr(piece, '\n', end - piece))){
+            addLine(batch, piece, newline - piece);
+            piece = newline + 1;
+        }
+
+        size_t rest = end - piece;
+        if (rest > STREAM_THRESHOLD){ // Too long to carry, the executor starts assembling it
+            addPieces(batch, piece, rest, 0);
+            streaming = 1;
+        }
+        else{
+            memcpy(carry, piece, rest);
+            carried = rest;
+        }
+
+        if (!sendBatch(pipeline, batch, &next))
+            break;
+    }
+    free(carry);
+}
+
+/**
+ * @brief Body of the reader thread
+ * @param argument The pipeline
+ * @return NULL
+ */
+static void* readerMain(void *argument){
+    Pipeline *pipeline = argument;
+    if (pipeline->mapped)
+        readMapped(pipeline);
+    else
+        readStream(pipeline);
+    return NULL;
+}
+
+/**
+ * @brief Lex and match every line of a batch, the same steps handleLine takes before it executes a line
+ * @param stage The parser
+ * @param batch The batch
+ */
+static void parseBatch(ParserStage *stage, Batch *batch){
+    for (int i = 0; i < batch->count; i++){
+        LineRecord *record = &batch->records[i];
+        if (record->kind != RECORD_LINE)
+            continue;
+
+        if (record->length >= stage->tokenCapacity){ // A line never has more tokens than characters
+            stage->tokenCapacity = record->length + 1;
+            stage->tokens = realloc(stage->tokens, stage->tokenCapacity*sizeof(Token));
+            if (!stage->tokens){
+                printf("Memory reallocation failed!");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        int size = lexLine(record->line, record->length, stage->tokens);
+        if (size == 1 && stage->tokens[0].keyword == KW_EXIT){
+            record->kind = RECORD_EXIT;
+            continue;
+        }
+        if (size < 2 || !parseCommand(record->line, stage->tokens, size, &record->command)){
+            record->kind = RECORD_INVALID;
+            continue;
+        }
+
+        if (batch->tokenCount + size > batch->tokenCapacity){ // The command keeps its tokens in the batch
+            int newCapacity = batch->tokenCapacity ? batch->tokenCapacity : 4096;
+            while (newCapacity < batch->tokenCount + size)
+                newCapacity *= 2;
+            Token *newTokens = realloc(batch->tokens, newCapacity*sizeof(Token));
+            if (!newTokens){
+                printf("Memory reallocation failed!");
+                exit(EXIT_FAILURE);
+            }
+            batch->tokens = newTokens;
+            batch->tokenCapacity = newCapacity;
+        }
+        resolveArguments(&record->command, stage->symbolReader); // Names the executor interned already
+        memcpy(batch->tokens + batch->tokenCount, stage->tokens, size*sizeof(Token));
+        record->kind = RECORD_COMMAND;
+        record->tokenStart = batch->tokenCount;
+        batch->tokenCount += size;
+    }
+
+    for (int i = 0; i < batch->count; i++){ // The tokens do not move any more
+        if (batch->records[i].kind == RECORD_COMMAND)
+            batch->records[i].command.tokens = batch->tokens + batch->records[i].tokenStart;
+    }
+}
+
+/**
+ * @brief Body of a parser thread
+ * @param argument The parser
+ * @return NULL
+ */
+static void* parserMain(void *argument){
+    ParserStage *stage = argument;
+    void *item;
+
+    while (waitPop(stage->pipeline, &stage->batches, &item)){
+        if (item)
+            parseBatch(stage, item);
+        if (!waitPush(stage->pipeline, &stage->parsed, item) || !item) // The end of the input is passed on too
+            break;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Execute the records of a batch in order
+ * @param batch The batch
+ * @param inventory The inventory
+ * @param scratch The arena of the line
+ * @param assembler The assembler of long lines
+ * @param handleLine Executes a long line once the assembler has it whole
+ * @return 0 if Exit was executed, 1 otherwise
+ */
+static int executeBatch(Batch *batch, Inventory *inventory, Arena *scratch, LineAssembler *assembler, LineHandler handleLine){
+    for (int i = 0; i < batch->count; i++){
+        LineRecord *record = &batch->records[i];
+        const char *line;
+        size_t length;
+
+        switch (record->kind){
+            case RECORD_COMMAND:
+                executeCommand(inventory, &record->command, scratch);
+                resetArena(scratch);
+                break;
+            case RECORD_INVALID:
+                outPrintf("INVALID\n");
+                break;
+            case RECORD_EXIT:
+                return 0;
+            case RECORD_PIECE:
+            case RECORD_LAST_PIECE:
+                if (record->length > 0)
+                    feedLine(assembler, record->line, record->length);
+                if (record->kind == RECORD_LAST_PIECE && endLine(assembler, inventory, &line, &length) && !handleLine(line, length))
+                    return 0;
+                break;
+            case RECORD_LINE: // Parsers leave none
+                break;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Create the batches and queues and start the reader and the parsers
+ * @param pipeline The pipeline
+ * @param mapped The mapped input, NULL for stdin
+ * @param parserCount The number of parser threads
+ */
+static void startPipeline(Pipeline *pipeline, MappedInput *mapped, int parserCount){
+    pipeline->mapped = mapped;
+    pipeline->parserCount = parserCount;
+    pipeline->poolSize = parserCount*2*PIPELINE_QUEUE_BATCHES + 2; // Both queues of every parser full, one batch read and one executed
+    pipeline->pool = calloc(pipeline->poolSize, sizeof(Batch));
+    pipeline->parsers = calloc(parserCount, sizeof(ParserStage));
+    if (!pipeline->pool || !pipeline->parsers){
+        printf("Memory allocation failed!");
+        exit(EXIT_FAILURE);
+    }
+
+    initializeRing(&pipeline->freeBatches, pipeline->poolSize);
+    for (int i = 0; i < pipeline->poolSize; i++){
+        if (!mapped && !(pipeline->pool[i].text = malloc(2*STREAM_THRESHOLD))){ // Carried bytes and one read
+            printf("Memory allocation failed!");
+            exit(EXIT_FAILURE);
+        }
+        ringPush(&pipeline->freeBatches, &pipeline->pool[i]);
+    }
+
+    initializeCommandTable(); // Before any parser matches a line
+    atomic_init(&pipeline->stopping, 0);
+    if (pipe(pipeline->wake) == -1){
+        printf("Can not start the pipeline!");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < parserCount; i++){
+        ParserStage *stage = &pipeline->parsers[i];
+        stage->pipeline = pipeline;
+        stage->symbolReader = registerSymbolReader();
+        initializeRing(&stage->batches, PIPELINE_QUEUE_BATCHES);
+        initializeRing(&stage->parsed, PIPELINE_QUEUE_BATCHES);
+        if (pthread_create(&stage->thread, NULL, parserMain, stage) != 0){
+            printf("Can not start the pipeline!");
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (pthread_create(&pipeline->reader, NULL, readerMain, pipeline) != 0){
+        printf("Can not start the pipeline!");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * @brief Wait for the reader and the parsers and free everything
+ * @param pipeline The pipeline
+ * @param stop 1 to end the stages early, after Exit
+ */
+static void stopPipeline(Pipeline *pipeline, int stop){
+    if (stop){
+        atomic_store_explicit(&pipeline->stopping, 1, memory_order_relaxed);
+        ssize_t woken = write(pipeline->wake[1], "", 1); // The pipe is empty, the write can not block
+        (void)woken;
+    }
+
+    pthread_join(pipeline->reader, NULL);
+    for (int i = 0; i < pipeline->parserCount; i++){
+        pthread_join(pipeline->parsers[i].thread, NULL);
+        freeRing(&pipeline->parsers[i].batches);
+        freeRing(&pipeline->parsers[i].parsed);
+        free(pipeline->parsers[i].tokens);
+    }
+    for (int i = 0; i < pipeline->poolSize; i++){
+        free(pipeline->pool[i].records);
+        free(pipeline->pool[i].tokens);
+        free(pipeline->pool[i].text);
+    }
+
+    freeRing(&pipeline->freeBatches);
+    free(pipeline->pool);
+    free(pipeline->parsers);
+    close(pipeline->wake[0]);
+    close(pipeline->wake[1]);
+}
+
+/**
+ * @brief Execute the lines of a mapped input or of stdin with the reading and parsing done ahead by other
+ * threads. The commands run on the calling thread, in input order
+ * @param mapped The mapped input, NULL to read stdin
+ * @param parserCount The number of parser threads, at least 1
+ * @param inventory The inventory
+ * @param scratch The arena of the line
+ * @param assembler The assembler of long lines
+ * @param handleLine Executes a long line once the assembler has it whole
+ * @return 0 if Exit was read, 1 at the end of the input
+ */
+int runPipeline(MappedInput *mapped, int parserCount, Inventory *inventory, Arena *scratch, LineAssembler *assembler, LineHandler handleLine){
+    Pipeline pipeline;
+    int exitRead = 0;
+    int next = 0; // Batches executed so far
+    void *item;
+
+    startPipeline(&pipeline, mapped, parserCount);
+
+    while (waitParsed(&pipeline, &pipeline.parsers[next % parserCount].parsed, &item, inventory->journal) && item){
+        next++;
+        exitRead = !executeBatch(item, inventory, scratch, assembler, handleLine);
+        ringPush(&pipeline.freeBatches, item); // Never full, it has room for the whole pool
+        if (exitRead)
+            break;
+    }
+
+    stopPipeline(&pipeline, exitRead);
+    return !exitRead;
+}
@@ -1,250 +1,211 @@
 #include "hashmap.h"
 #include "structures.h"
+#include "typed_maps.h"
+#include "symbols.h"
 #include "helper_methods.h"
+#include "output.h"
 #include <stdio.h>
+#include <inttypes.h>
+
+/*
+ * Queries run on the thread that executes commands and never at the same time as a change. Reading a
+ * table is not read-only: orderedSymbols merges the names added since the last query into the sorted
+ * index and the answer is rendered into the cache of the table.
+ */
 
 /**
  * @brief Prints the amount of a specific ingredient
- * @param ingredients The hashmap containing the ingredients
+ * @param ingredients The table containing the ingredients
  * @param ingredient The name of the ingredient
  */
-void specificIngredients(HashMap *ingredients, char *ingredient){
-    if(contains(ingredients, ingredient)){ // Checks if ingredient is available
-        int *amount = get(ingredients, ingredient);
-        printf("%d\n", *amount);
-    }
-    else{ // If ingredient is not available
-        printf("0\n");
-    }
+void specificIngredients(CounterTable *ingredients, Symbol ingredient){
+    int64_t *amount = findCounter(ingredients, ingredient); // Ingredients that were never looted have no entry
+    outPrintf("%" PRId64 "\n", amount ? *amount : 0);
 }
 
 /**
  * @brief Prints the amount of a specific potion
- * @param potions The hashmap containing the potions
+ * @param potions The table containing the potions
  * @param potion The name of the potion
  */
-void specificPotion(HashMap *potions, char *potion){
-    if(contains(potions, potion)){  // Checks if potion is available
-        Potion *p = (Potion *)get(potions, potion);
-        printf("%d\n", p->potionCount);
-        return;
-    }
-    else{  // If it is not in the potions list
-        printf("0\n");
-    }
+void specificPotion(PotionTable *potions, Symbol potion){
+    Potion *p = findPotion(potions, potion); // Unknown potions have a count of 0
+    outPrintf("%" PRId64 "\n", p ? p->potionCount : 0);
 }
 
 /**
  * @brief Prints the amount of a specific trophy
- * @param trophies The hashmap containing the trophies
+ * @param trophies The table containing the trophies
  * @param trophy The name of the trophy
  */
-void specificTrophies(HashMap *trophies, char *trophy){
-    if(contains(trophies, trophy)){ // Checks if troph is available
-        int *amount = get(trophies, trophy);
-        printf("%d\n", *amount);
-    }
-    else{ // If it is not in the trophies list
-        printf("0\n");
-    }
+void specificTrophies(CounterTable *trophies, Symbol trophy){
+    int64_t *amount = findCounter(trophies, trophy); // Trophies that were never collected have no entry
+    outPrintf("%" PRId64 "\n", amount ? *amount : 0);
 }
 
 /**
- * @brief Prints the amount of all ingredients
- * @param ingredients The hashmap containing the ingredients
+ * @brief Prints the amount and name of every non-zero entry of a counter table, sorted by name.
+ * The answer is rendered once per version of the table
+ * @param map The table containing the ingredients or trophies
  */
-void allIngredients(HashMap *ingredients){
-    int ingredientCount = countQuantity(ingredients); // Number of ingredient entries in the hashmap 
-    if (ingredientCount == 0){
-        printf("None\n");
+static void printCounters(CounterTable *map){
+    RenderCache *cache = &map->rendered;
+    if (renderCacheHit(cache, map->version)) // Nothing changed since the last Total query
         return;
-    }
-    char** array_of_keys = createArrayOfKeys(ingredients);  // Array consisting of the names of the ingredients
-    int c = ingredients->size;  // Number of distinct ingredients
-
-    int realCount = 0; // Number of non-zero entries in the hashmap
 
-    // Iterate through the hashmap and find real count
-    for (int i = 0; i < c; i++){
-        if (*(int *)get(ingredients, array_of_keys[i]) != 0)
-            realCount++;
+    if (map->total == 0){ // Running sum of the table
+        renderAppend(cache, "None\n");
+        renderCommit(cache, map->version);
+        return;
     }
 
-    qsort(array_of_keys, c, sizeof(char *), compareStrings);  // Sort the array by string comparion
+    int c; // Number of names the table has seen
+    const Symbol *keys = orderedSymbols(&map->index, &c);  // Names ordered by string comparison
+    int remaining = map->nonzero; // Entries left to print
 
-    int k = 0; // Current iteration
-
-    for (int i = 0; i < c; i++){
-        char *key = array_of_keys[i];  // Current ingredient name
-        int val = *(int *)get(ingredients, array_of_keys[i]);  // Current ingredient value
-
-        if (val == 0)  // Do not print ingredients with value 0
+    for (int i = 0; i < c && remaining > 0; i++){
+        int64_t val = map->entries[keys[i]];  // Current amount
+        if (val == 0) // Only names with a count are listed
             continue;
-        k++;
-        if (k == realCount) // Last ingredient to print
-            printf("%d %s\n", val, key);
+
+        if (--remaining == 0) // Last entry to print
+            renderAppend(cache, "%" PRId64 " %s\n", val, symbolName(keys[i]));
         else
-            printf("%d %s, ", val, key);
+            renderAppend(cache, "%" PRId64 " %s, ", val, symbolName(keys[i]));
     }
+    renderCommit(cache, map->version);
+}
 
-    freeArrayOfKeys(array_of_keys, c);  // Free the array since we allocated extra memory for it
-
+/**
+ * @brief Prints the amount of all ingredients
+ * @param ingredients The table containing the ingredients
+ */
+void allIngredients(CounterTable *ingredients){
+    printCounters(ingredients);
 }
 
 /**
  * @brief Printf the amount and name of all potions
- * @param potions The hashmap containing the potions
+ * @param potions The table containing the potions
  */
-void allPotions(HashMap *potions){
-    if (countPotions(potions) == 0){
-        printf("None\n");
+void allPotions(PotionTable *potions){
+    RenderCache *cache = &potions->rendered;
+    if (renderCacheHit(cache, potions->version)) // Nothing brewed or used since the last Total query
         return;
-    }
-    
-    char** array_of_keys = createArrayOfKeys(potions);  // Array consisting of the names of the potions
-    int c = potions->size;  // Number of distinct potions
-    int realCount = 0;
-
-    for (int i = 0; i < c; i++){
-        Potion *potion = (Potion *)get(potions, array_of_keys[i]);  // Corresponding Potion structure of current potion name
-        int potionCount = potion->potionCount;  // Amount of current potion
 
-        if (potionCount != 0)
-            realCount++;
+    if (potions->total == 0){ // Running sum of the brewed amounts
+        renderAppend(cache, "None\n");
+        renderCommit(cache, potions->version);
+        return;
     }
 
-    qsort(array_of_keys, c, sizeof(char *), compareStrings);  // Sort the array by string comparison
+    int c; // Number of potions the table has seen
+    const Symbol *keys = orderedSymbols(&potions->index, &c);  // Potion names ordered by string comparison
+    int remaining = potions->nonzero; // Potions left to print
 
-    int count = 0;
-
-    for (int i = 0; i < c; i++){
-        char *key = array_of_keys[i];  // Current potion name
-        Potion *potion = (Potion *)get(potions, array_of_keys[i]);  // Corresponding Potion structure of current potion name
-        int potionCount = potion->potionCount;  // Amount of current potion
-
-
-        if (potionCount == 0)  // Do not print potionts with amount 0
+    for (int i = 0; i < c && remaining > 0; i++){
+        int64_t potionCount = potions->entries[keys[i]].potionCount;  // Amount of current potion
+        if (potionCount == 0) // Only potions in stock are listed
             continue;
-        
-        count++;
-        
-        if (count == realCount)
-            printf("%d %s\n", potionCount, key);
+
+        if (--remaining == 0) // Last potion to print
+            renderAppend(cache, "%" PRId64 " %s\n", potionCount, symbolName(keys[i]));
         else
-            printf("%d %s, ", potionCount, key);
+            renderAppend(cache, "%" PRId64 " %s, ", potionCount, symbolName(keys[i]));
     }
-
-    freeArrayOfKeys(array_of_keys, c);  // Free the allocated memory since we created extra memory for it
+    renderCommit(cache, potions->version);
 }
 
 /**
  * @brief Prints the amount and name of all trophies
- * @param trophies The hashmap containing the trophies
+ * @param trophies The table containing the trophies
  */
-void allTrophies(HashMap* trophies){
-    int trophyCount = countQuantity(trophies); // Number of trophy entries in the hashmap
-    if (trophyCount == 0){
-        printf("None\n");
-        return;
-    }
-
-    char** array_of_keys = createArrayOfKeys(trophies);  // Array consisting of name of the trophies
-    int c = trophies->size;  // Number of distinct trophies
-
-    int realCount = 0; // Number of non-zero entries in the hashmap
-
-    // Iterate through the hashmap and find the real count of trophies
-    for (int i = 0; i < c; i++){
-        if (*(int *)get(trophies, array_of_keys[i]) != 0)
-            realCount++;
-    }
-
-    qsort(array_of_keys, c, sizeof(char *), compareStrings);  // Sort the array by string comparison
-
-    int k = 0; // Current iteration
-    for (int i = 0; i < c; i++){
-        char *key = array_of_keys[i];  // Current trophy name
-        int val = *(int *)get(trophies, array_of_keys[i]);  // Current trophy amount
-
-        if (val == 0)  // Do not print trophies with 0 amount
-            continue;
-        k++;
-        if (k == realCount) // Last trophy to print
-            printf("%d %s\n", val, key);
-        else
-            printf("%d %s, ", val, key);
-    }
-
-    freeArrayOfKeys(array_of_keys, c);  // Free the allocated memory for the array since we created extra memory for it
+void allTrophies(CounterTable* trophies){
+    printCounters(trophies);
 }
 
 /**
  * @brief Prints the effective potions and signs for a specific monster
- * @param monsters The hashmap containing the monsters
- * @param monster The name of the monster
+ * @param monsters The table containing the monsters
+ * @param monster The symbol of the monster, NO_SYMBOL if it was never named
+ * @param name The name of the monster
  */
-void potionSignEffectiveness(HashMap *monsters, char *monster){
-    Bestiary *b = (Bestiary*)(get(monsters, monster));
+void potionSignEffectiveness(BestiaryTable *monsters, Symbol monster, const char *name){
+    Bestiary *b = findMonster(monsters, monster);
 
-    if (!b){
-        printf("No knowledge of %s\n", monster);
+    if (!b || (b->potionCount == 0 && b->signCount == 0)){
+        outPrintf("No knowledge of %s\n", name);
     }
-    else{
-        char **effectivePotions = b->effectivePotions; // Effective potions against the monster
-        char **effectiveSigns = b->effectiveSigns; // Effective signs against the monster
-        
+    else if (!renderCacheHit(&b->rendered, b->version)){ // Render only if something was learned since the last query
         int c = b->potionCount + b->signCount; // Number of effective potion/signs
 
-        char **effectiveTotal = malloc(c * sizeof(char *)); // Allocate memory for the total effective array
-
-        // Add elements to effective total array
-        int k = 0;
-        for (int i = 0; i < b->potionCount; i++){
-            effectiveTotal[k++] = effectivePotions[i];
-        }
-        for (int j = 0; j < b->signCount; j++){
-            effectiveTotal[k++] = effectiveSigns[j];
-        }
-
-        qsort(effectiveTotal, k, sizeof(char*), compareStrings); // Sort the array by string comparison
-        
-        // Print out the effective potion/signs
+        // The merged list is kept in order as entries are learned
         for (int i = 0; i < c; i++){
             if (i == c-1)
-                printf("%s\n", effectiveTotal[i]);
+                renderAppend(&b->rendered, "%s\n", symbolName(b->merged[i]));
             else
-                printf("%s, ", effectiveTotal[i]);
+                renderAppend(&b->rendered, "%s, ", symbolName(b->merged[i]));
         }
-        
-        free(effectiveTotal);
+        renderCommit(&b->rendered, b->version);
     }
 }
 
 /**
  * @brief Prints the formula of a specific potion
- * @param potions The hashmap containing the potions
- * @param potion The name of the potion
+ * @param potions The table containing the potions
+ * @param potion The symbol of the potion, NO_SYMBOL if it was never named
+ * @param name The name of the potion
  */
-void potionFormula(HashMap *potions,char *potion){
-    Potion *p = (Potion *)get(potions, potion);
-    if(!p){
-        printf("No formula for %s\n", potion);
-    }
-    else{
-        PairArray *recipe = p->recipe; // Recipe of the potion
-        if(!recipe) // No formula for the potion (not possible I guess)
-            printf("No formula for %s\n", potion);
-        else{
-            Pair **arr = recipe->array; // Pair array representin recipe
-            qsort(arr, recipe->size, sizeof(Pair *), comparePotionFormula); // Sort the array according to potion comparison
-
-            // Print out the ingredients in the potion
-            for(int i = 0; i<recipe->size; i++){
-                if(i == recipe->size - 1)
-                    printf("%d %s\n", arr[i]->count, arr[i]->key);
-                else
-                    printf("%d %s, ", arr[i]->count, arr[i]->key);
-            }
+void potionFormula(PotionTable *potions, Symbol potion, const char *name){
+    Potion *p = findPotion(potions, potion);
+    if(!p || !p->recipe){ // Potion was never learned
+        outPrintf("No formula for %s\n", name);
+    }
+    else if (!renderCacheHit(&p->rendered, p->version)){ // Recipes rarely change, render once
+        const Recipe *recipe = p->recipe; // Recipe of the potion, already in formula order
+        const Pair *arr = recipe->pairs;
+
+        // Print out the ingredients in the potion
+        for(int i = 0; i<recipe->size; i++){
+            if(i == recipe->size - 1)
+                renderAppend(&p->rendered, "%d %s\n", arr[i].count, symbolName(arr[i].key));
+            else
+                renderAppend(&p->rendered, "%d %s, ", arr[i].count, symbolName(arr[i].key));
         }
+        renderCommit(&p->rendered, p->version);
+    }
+}
+
+
+/**
+ * @brief Prints how many times a potion can be brewed with the ingredients at hand
+ * @param potions The table containing the potions
+ * @param potion The symbol of the potion, NO_SYMBOL if it was never named
+ * @param name The name of the potion
+ */
+void specificBrewable(PotionTable *potions, Symbol potion, const char *name){
+    Potion *p = findPotion(potions, potion);
+    if (!p || !p->recipe) // Potion was never learned
+        outPrintf("No formula for %s\n", name);
+    else
+        outPrintf("%" PRId64 "\n", p->brewable); // Kept up to date by the brew index
+}
+
+/**
+ * @brief Prints the amount and name of every potion that can be brewed at least once, sorted by name
+ * @param potions The table containing the potions
+ */
+void allBrewable(PotionTable *potions){
+    int c; // Number of potions the table has seen
+    const Symbol *keys = orderedSymbols(&potions->index, &c);  // Potion names ordered by string comparison
+    int printed = 0; // Potions printed so far
+
+    for (int i = 0; i < c; i++){
+        const Potion *p = &potions->entries[keys[i]];
+        if (!p->recipe || p->brewable == 0) // Only potions the ingredients allow are listed
+            continue;
+
+        outPrintf(printed++ ? ", %" PRId64 " %s" : "%" PRId64 " %s", p->brewable, symbolName(keys[i]));
     }
+    outPrintf(printed ? "\n" : "None\n");
 }
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "render_cache.h"
+#include "output.h"
+
+static long long hits = 0; // Queries answered from a cache
+static long long misses = 0; // Queries that had to be rendered
+
+/**
+ * @brief Answer a query from its cache if the owner has not changed since the cache was rendered.
+ * On a hit the cached text is written to the output, on a miss the cache is emptied for a new render
+ * @param cache The cache of the query
+ * @param version The current version of the owner of the cache
+ * @return 1 if the query was answered, 0 if the caller must render it
+ */
+int renderCacheHit(RenderCache *cache, uint64_t version){
+    if (cache->valid && cache->version == version){
+        outWrite(cache->text, cache->length);
+        hits++;
+        return 1;
+    }
+
+    cache->length = 0;
+    cache->valid = 0;
+    misses++;
+    return 0;
+}
+
+/**
+ * @brief Append formatted text to a cache that is being rendered
+ * @param cache The cache
+ * @param format The printf format
+ */
+void renderAppend(RenderCache *cache, const char *format, ...){
+    va_list args;
+
+    va_start(args, format);
+    int needed = vsnprintf(cache->text + cache->length, cache->capacity - cache->length, format, args); // Try the free space first
+    va_end(args);
+
+    if (cache->length + needed + 1 > cache->capacity){ // Did not fit, grow and format again
+        size_t newCapacity = cache->capacity ? cache->capacity : 64;
+        while (newCapacity < cache->length + needed + 1)
+            newCapacity *= 2;
+
+        char *newText = realloc(cache->text, newCapacity);
+        if (!newText){
+            printf("Memory reallocation failed!");
+            exit(EXIT_FAILURE);
+        }
+        cache->text = newText;
+        cache->capacity = newCapacity;
+
+        va_start(args, format);
+        vsnprintf(cache->text + cache->length, cache->capacity - cache->length, format, args);
+        va_end(args);
+    }
+
+    cache->length += needed;
+}
+
+/**
+ * @brief Finish a render, the text is written to the output and kept for the given version
+ * @param cache The cache
+ * @param version The version of the owner the text was rendered from
+ */
+void renderCommit(RenderCache *cache, uint64_t version){
+    outWrite(cache->text, cache->length);
+    cache->version = version;
+    cache->valid = 1;
+}
+
+/**
+ * @brief Free the memory owned by a cache
+ * @param cache The cache
+ */
+void freeRenderCache(RenderCache *cache){
+    free(cache->text);
+    cache->text = NULL;
+    cache->length = 0;
+    cache->capacity = 0;
+    cache->valid = 0;
+}
+
+/**
+ * @brief Get the number of cache hits and misses of every query cache since the start
+ * @param hitCount Set to the number of hits
+ * @param missCount Set to the number of misses
+ */
+void renderCacheStats(long long *hitCount, long long *missCount){
+    *hitCount = hits;
+    *missCount = misses;
+}
@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "ring.h"
+
+/**
+ * @brief Initialize an empty ring
+ * @param ring The ring
+ * @param capacity The least number of items it must hold, rounded up to a power of two
+ */
+void initializeRing(Ring *ring, size_t capacity){
+    size_t size = 1;
+    while (size < capacity)
+        size *= 2;
+
+    ring->slots = malloc(size*sizeof(void*));
+    if (!ring->slots){
+        printf("Memory allocation failed!");
+        exit(EXIT_FAILURE);
+    }
+    ring->mask = size - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+}
+
+/**
+ * @brief Add an item at the back, only the producer thread may call this
+ * @param ring The ring
+ * @param item The item
+ * @return 1 if the item was added, 0 if the ring is full
+ */
+int ringPush(Ring *ring, void *item){
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire); // The consumer is done with the slot
+
+    if (tail - head > ring->mask)
+        return 0;
+
+    ring->slots[tail & ring->mask] = item;
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release); // Publishes the slot
+    return 1;
+}
+
+/**
+ * @brief Take the item at the front, only the consumer thread may call this
+ * @param ring The ring
+ * @param item Receives the item
+ * @return 1 if an item was taken, 0 if the ring is empty
+ */
+int ringPop(Ring *ring, void **item){
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire); // The slot is written
+
+    if (head == tail)
+        return 0;
+
+    *item = ring->slots[head & ring->mask];
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release); // Hands the slot back
+    return 1;
+}
+
+/**
+ * @brief Free the slots of a ring, the items are not touched
+ * @param ring The ring
+ */
+void freeRing(Ring *ring){
+    free(ring->slots);
+    ring->slots = NULL;
+}
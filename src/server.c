@@ -0,0 +1,242 @@
+#define _GNU_SOURCE // accept4
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "server.h"
+#include "journal.h"
+
+/*
+ * Server mode serves every client from one thread. A client may send any number of lines without
+ * waiting for answers, its lines run in the order they arrive and the answers are queued for it in the
+ * same order. Lines of different clients never run at the same time, so the tables stay consistent.
+ */
+
+static volatile sig_atomic_t stopRequested = 0; // Set by SIGINT or SIGTERM
+
+/**
+ * @brief Ask the event loop to stop after the events it is handling
+ * @param signal The signal
+ */
+static void requestStop(int signal){
+    (void)signal;
+    stopRequested = 1;
+}
+
+/**
+ * @brief Create the listening socket, a stale socket file left at the path is replaced
+ * @param path The path of the socket
+ * @return The socket, -1 on failure
+ */
+static int openListener(const char *path){
+    struct sockaddr_un address;
+    struct stat st;
+
+    if (strlen(path) >= sizeof(address.sun_path))
+        return -1;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    if (stat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+        unlink(path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1)
+        return -1;
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) == -1 || listen(fd, SOMAXCONN) == -1){
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Register a client for the events it needs: answers to send, and more lines unless it is closing
+ * or too far behind on its answers
+ * @param epollFd The epoll instance
+ * @param client The client
+ */
+static void updateEvents(int epollFd, Client *client){
+    size_t unsent = client->output.length - client->sent;
+    unsigned int events = 0;
+
+    if (!client->closing && unsent < CLIENT_OUTPUT_LIMIT)
+        events |= EPOLLIN;
+    if (unsent > 0)
+        events |= EPOLLOUT;
+
+    if (events != client->events){
+        struct epoll_event event = {.events = events, .data.ptr = client};
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, client->fd, &event);
+        client->events = events;
+    }
+}
+
+/**
+ * @brief Close a client and free its memory
+ * @param client The client
+ */
+static void closeClient(Client *client){
+    close(client->fd); // Also removes it from epoll
+    freeAssembler(&client->assembler);
+    free(client->output.data);
+    free(client);
+}
+
+/**
+ * @brief Accept every pending connection
+ * @param epollFd The epoll instance
+ * @param listenFd The listening socket
+ */
+static void acceptClients(int epollFd, int listenFd){
+    while (1){
+        int fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == -1) // EAGAIN once every connection is taken, errors only affect that connection
+            return;
+
+        Client *client = malloc(sizeof(Client));
+        if (!client){
+            printf("Memory allocation failed!");
+            exit(EXIT_FAILURE);
+        }
+        client->fd = fd;
+        initializeAssembler(&client->assembler);
+        memset(&client->output, 0, sizeof(OutputBuffer));
+        client->sent = 0;
+        client->closing = 0;
+        client->events = EPOLLIN;
+
+        struct epoll_event event = {.events = EPOLLIN, .data.ptr = client};
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == -1)
+            closeClient(client);
+    }
+}
+
+/**
+ * @brief Send as many queued answers as the socket takes
+ * @param client The client
+ * @return 1 if the client is still usable, 0 if its connection broke
+ */
+static int sendAnswers(Client *client){
+    while (client->sent < client->output.length){
+        ssize_t written = send(client->fd, client->output.data + client->sent, client->output.length - client->sent, MSG_NOSIGNAL);
+        if (written == -1){
+            if (errno == EINTR)
+                continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        client->sent += written;
+    }
+    client->output.length = 0; // Everything is sent, start over at the front
+    client->sent = 0;
+    return 1;
+}
+
+/**
+ * @brief Read one chunk from a client and execute its complete lines, the answers are queued for it
+ * @param client The client
+ * @param executeChunk Runs the lines of a chunk
+ * @param finishInput Runs the last line of an input without a new line character
+ * @return 1 if the client is still usable, 0 if its connection broke
+ */
+static int readLines(Client *client, ChunkHandler executeChunk, InputEndHandler finishInput){
+    static char chunk[STREAM_THRESHOLD]; // One chunk per client per wake up keeps the clients fair
+
+    ssize_t count = read(client->fd, chunk, sizeof(chunk));
+    if (count == -1)
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+    outRedirect(&client->output);
+    if (count == 0){ // The client is done sending
+        finishInput(&client->assembler);
+        client->closing = 1;
+    }
+    else if (!executeChunk(&client->assembler, chunk, count)){ // Exit closes the connection, not the server
+        client->closing = 1;
+    }
+    outRedirect(NULL);
+    return 1;
+}
+
+/**
+ * @brief Serve clients on a Unix domain socket until SIGINT or SIGTERM
+ * @param path The path of the socket
+ * @param inventory The inventory every client works on
+ * @param executeChunk Runs the lines of a chunk of a client
+ * @param finishInput Runs the last line of a client that ended without a new line character
+ * @return 1 after a stop was requested, 0 if the socket could not be set up
+ */
+int runServer(const char *path, Inventory *inventory, ChunkHandler executeChunk, InputEndHandler finishInput){
+    int listenFd = openListener(path);
+    if (listenFd == -1)
+        return 0;
+
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event event = {.events = EPOLLIN, .data.ptr = NULL}; // No client, the listener
+    if (epollFd == -1 || epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event) == -1){
+        close(listenFd);
+        unlink(path);
+        return 0;
+    }
+
+    // The signals only arrive while epoll waits, so a stop is never missed between two waits
+    sigset_t blocked, waiting, original;
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = requestStop;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    sigemptyset(&blocked);
+    sigaddset(&blocked, SIGINT);
+    sigaddset(&blocked, SIGTERM);
+    sigprocmask(SIG_BLOCK, &blocked, &original);
+    waiting = original;
+    sigdelset(&waiting, SIGINT);
+    sigdelset(&waiting, SIGTERM);
+
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    while (!stopRequested){
+        int timeout = inventory->journal && inventory->journal->used > 0 ? JOURNAL_GROUP_MILLISECONDS : -1; // Pending records must not wait for the next line
+        int count = epoll_pwait(epollFd, events, SERVER_MAX_EVENTS, timeout, &waiting);
+        if (count == -1 && errno != EINTR)
+            break;
+        if (count <= 0){
+            if (inventory->journal)
+                commitJournal(inventory->journal);
+            continue;
+        }
+
+        for (int i = 0; i < count; i++){
+            Client *client = events[i].data.ptr;
+            if (!client){
+                acceptClients(epollFd, listenFd);
+                continue;
+            }
+
+            int usable = 1;
+            if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && !client->closing)
+                usable = readLines(client, executeChunk, finishInput);
+            if (usable)
+                usable = sendAnswers(client);
+
+            if (!usable || (client->closing && client->output.length == 0))
+                closeClient(client);
+            else
+                updateEvents(epollFd, client);
+        }
+    }
+
+    sigprocmask(SIG_SETMASK, &original, NULL);
+    close(epollFd); // Clients still connected are dropped with the process
+    close(listenFd);
+    unlink(path);
+    return 1;
+}
@@ -0,0 +1,420 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "snapshot.h"
+#include "helper_methods.h"
+#include "input.h"
+#include "actions.h"
+
+typedef struct{
+    const char *data; // Mapping of the snapshot
+    size_t size;
+    size_t offset; // Start of the next part
+}SnapshotReader;
+
+/**
+ * @brief Write the zeros that bring a part of a snapshot to a multiple of 8 bytes
+ * @param file The snapshot
+ * @param size The size of the part
+ * @return 1 on success, 0 on a write error
+ */
+static int writePadding(FILE *file, uint64_t size){
+    static const char zeros[8];
+    size_t padding = (8 - size % 8) % 8;
+    return fwrite(zeros, 1, padding, file) == padding;
+}
+
+/**
+ * @brief Write bytes to a snapshot, followed by zeros up to the next multiple of 8 bytes
+ * @param file The snapshot
+ * @param data The bytes
+ * @param size The number of bytes
+ * @return 1 on success, 0 on a write error
+ */
+static int writePadded(FILE *file, const void *data, size_t size){
+    if (size > 0 && fwrite(data, 1, size, file) != size)
+        return 0;
+    return writePadding(file, size);
+}
+
+/**
+ * @brief Write the records of a counter table, one per symbol the table has seen
+ * @param file The snapshot
+ * @param counters The counter table
+ * @return 1 on success, 0 on a write error
+ */
+static int writeCounters(FILE *file, CounterTable *counters){
+    int c;
+    const Symbol *keys = orderedSymbols(&counters->index, &c);
+
+    for (int i = 0; i < c; i++){
+        SnapshotCounter record = {keys[i], 0, counters->entries[keys[i]]};
+        if (!writePadded(file, &record, sizeof(record)))
+            return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Check if a potion has anything to save, potions that were only asked about do not
+ * @param p The potion
+ * @return 1 if the potion has a recipe or a brewed amount, 0 otherwise
+ */
+static int potionKnown(const Potion *p){
+    return p->recipe != NULL || p->potionCount != 0;
+}
+
+/**
+ * @brief Write every part of a snapshot
+ * @param file The snapshot
+ * @param inventory The inventory to save
+ * @return 1 on success, 0 on a write error
+ */
+static int writeSnapshot(FILE *file, Inventory *inventory){
+    SnapshotHeader header;
+    int count;
+    const Symbol *keys;
+
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.symbolCount = symbolCount();
+    header.nameBytes = 0;
+    for (uint32_t i = 0; i < header.symbolCount; i++)
+        header.nameBytes += strlen(symbolName(i));
+
+    orderedSymbols(&inventory->ingredients->index, &count);
+    header.ingredientCount = count;
+    orderedSymbols(&inventory->trophies->index, &count);
+    header.trophyCount = count;
+
+    header.potionCount = 0;
+    keys = orderedSymbols(&inventory->potions->index, &count);
+    for (int i = 0; i < count; i++)
+        header.potionCount += potionKnown(&inventory->potions->entries[keys[i]]);
+
+    header.monsterCount = 0;
+    keys = orderedSymbols(&inventory->monsters->index, &count);
+    for (int i = 0; i < count; i++){
+        const Bestiary *b = &inventory->monsters->entries[keys[i]];
+        header.monsterCount += b->potionCount + b->signCount > 0;
+    }
+
+    if (!writePadded(file, &header, sizeof(header)))
+        return 0;
+
+    // Names, every symbol of the process keeps its id as its index in the file
+    uint64_t end = 0;
+    for (uint32_t i = 0; i < header.symbolCount; i++){
+        end += strlen(symbolName(i));
+        if (fwrite(&end, sizeof(end), 1, file) != 1)
+            return 0;
+    }
+    for (uint32_t i = 0; i < header.symbolCount; i++){
+        const char *name = symbolName(i);
+        size_t length = strlen(name);
+        if (length > 0 && fwrite(name, 1, length, file) != length)
+            return 0;
+    }
+    if (!writePadding(file, header.nameBytes))
+        return 0;
+
+    if (!writeCounters(file, inventory->ingredients) || !writeCounters(file, inventory->trophies))
+        return 0;
+
+    keys = orderedSymbols(&inventory->potions->index, &count);
+    for (int i = 0; i < count; i++){
+        const Potion *p = &inventory->potions->entries[keys[i]];
+        if (!potionKnown(p))
+            continue;
+
+        SnapshotPotion record = {keys[i], p->recipe ? p->recipe->size : 0, p->potionCount};
+        if (!writePadded(file, &record, sizeof(record)))
+            return 0;
+        for (uint32_t j = 0; j < record.pairCount; j++){
+            SnapshotPair pair = {p->recipe->pairs[j].key, p->recipe->pairs[j].count};
+            if (!writePadded(file, &pair, sizeof(pair)))
+                return 0;
+        }
+    }
+
+    keys = orderedSymbols(&inventory->monsters->index, &count);
+    for (int i = 0; i < count; i++){
+        const Bestiary *b = &inventory->monsters->entries[keys[i]];
+        int entries = b->potionCount + b->signCount;
+        if (entries == 0)
+            continue;
+
+        SnapshotMonster record = {keys[i], b->potionCount, b->signCount, 0};
+        if (!writePadded(file, &record, sizeof(record)))
+            return 0;
+        if (fwrite(b->effectivePotions, sizeof(Symbol), b->potionCount, file) != (size_t)b->potionCount ||
+            fwrite(b->effectiveSigns, sizeof(Symbol), b->signCount, file) != (size_t)b->signCount ||
+            fwrite(b->merged, sizeof(Symbol), entries, file) != (size_t)entries) // 2*entries ids, a multiple of 8 bytes
+            return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Save an inventory to a snapshot. The snapshot is written next to the path and renamed over it,
+ * so a failed save leaves an older snapshot intact
+ * @param inventory The inventory
+ * @param path The path of the snapshot
+ * @return 1 on success, 0 if the snapshot could not be written
+ */
+int saveSnapshot(Inventory *inventory, const char *path){
+    size_t length = strlen(path);
+    char *temporary = malloc(length + sizeof(".tmp"));
+    if (!temporary){
+        printf("Memory allocation failed!");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(temporary, path, length);
+    memcpy(temporary + length, ".tmp", sizeof(".tmp"));
+
+    FILE *file = fopen(temporary, "wb");
+    if (!file){
+        free(temporary);
+        return 0;
+    }
+
+    int written = writeSnapshot(file, inventory) && fflush(file) == 0 && fsync(fileno(file)) == 0; // A journal checkpoint relies on it
+    written = fclose(file) == 0 && written;
+    if (written)
+        written = rename(temporary, path) == 0;
+    if (!written)
+        remove(temporary);
+
+    free(temporary);
+    return written;
+}
+
+/**
+ * @brief Take the next bytes of a snapshot
+ * @param reader The reader
+ * @param size The number of bytes
+ * @return The bytes inside the mapping, NULL if the snapshot is too short
+ */
+static const void *takeBytes(SnapshotReader *reader, size_t size){
+    if (size > reader->size - reader->offset)
+        return NULL;
+
+    const void *bytes = reader->data + reader->offset;
+    reader->offset += size;
+    return bytes;
+}
+
+/**
+ * @brief Map the index of a name in the snapshot to the symbol of this process
+ * @param symbols The symbols of the names
+ * @param count The number of names
+ * @param index The index
+ * @param symbol Set to the symbol
+ * @return 1 if the index is a name of the snapshot, 0 otherwise
+ */
+static int mapSymbol(const Symbol *symbols, uint32_t count, uint32_t index, Symbol *symbol){
+    if (index >= count)
+        return 0;
+    *symbol = symbols[index];
+    return 1;
+}
+
+/**
+ * @brief Read the records of a counter table
+ * @param reader The reader
+ * @param counters The empty counter table to fill
+ * @param count The number of records
+ * @param symbols The symbols of the names
+ * @param symbolCount The number of names
+ * @return 1 on success, 0 if the records are damaged
+ */
+static int readCounters(SnapshotReader *reader, CounterTable *counters, uint32_t count, const Symbol *symbols, uint32_t symbolCount){
+    const SnapshotCounter *records = takeBytes(reader, (size_t)count*sizeof(SnapshotCounter));
+    if (!records)
+        return 0;
+
+    for (uint32_t i = 0; i < count; i++){
+        Symbol key;
+        if (!mapSymbol(symbols, symbolCount, records[i].symbol, &key))
+            return 0;
+        addToCounter(counters, key, records[i].amount); // 0 still gives the symbol its slot
+    }
+    return 1;
+}
+
+/**
+ * @brief Read the potions of a snapshot, recipes are rebuilt and indexed as if they were learned
+ * @param reader The reader
+ * @param inventory The inventory, its ingredients are already read
+ * @param count The number of potions
+ * @param symbols The symbols of the names
+ * @param symbolCount The number of names
+ * @param scratch Arena for the pairs of a recipe until it is copied
+ * @return 1 on success, 0 if the potions are damaged
+ */
+static int readPotions(SnapshotReader *reader, Inventory *inventory, uint32_t count, const Symbol *symbols, uint32_t symbolCount, Arena *scratch){
+    for (uint32_t i = 0; i < count; i++){
+        const SnapshotPotion *record = takeBytes(reader, sizeof(SnapshotPotion));
+        Symbol potion;
+        if (!record || !mapSymbol(symbols, symbolCount, record->symbol, &potion) || record->potionCount < 0)
+            return 0;
+
+        const SnapshotPair *pairs = takeBytes(reader, (size_t)record->pairCount*sizeof(SnapshotPair));
+        if (!pairs)
+            return 0;
+
+        if (record->pairCount > 0){
+            PairArray recipe = {arenaAlloc(scratch, (size_t)record->pairCount*sizeof(Pair)), (int)record->pairCount, (int)record->pairCount};
+            for (uint32_t j = 0; j < record->pairCount; j++){
+                if (!mapSymbol(symbols, symbolCount, pairs[j].symbol, &recipe.array[j].key) || pairs[j].count <= 0)
+                    return 0;
+                recipe.array[j].count = pairs[j].count;
+            }
+            if (!addPotionRecipe(inventory->potions, inventory->brewIndex, potion, &recipe)) // Every potion is saved once
+                return 0;
+        }
+        if (record->potionCount > 0)
+            addToPotion(inventory->potions, potion, record->potionCount);
+    }
+    return 1;
+}
+
+/**
+ * @brief Copy saved symbols into a new array of a monster, adding each one to its set
+ * @param ids The indexes of the names
+ * @param count The number of indexes
+ * @param symbols The symbols of the names
+ * @param symbolCount The number of names
+ * @param array Set to the new array
+ * @param set The set of the array, a symbol that is already in it damages the snapshot
+ * @return 1 on success, 0 if the indexes are damaged
+ */
+static int readEffective(const uint32_t *ids, uint32_t count, const Symbol *symbols, uint32_t symbolCount, Symbol **array, SymbolSet *set){
+    if (count == 0)
+        return 1;
+
+    *array = malloc(count*sizeof(Symbol));
+    if (!*array){
+        printf("Memory allocation failed!");
+        exit(EXIT_FAILURE);
+    }
+    for (uint32_t i = 0; i < count; i++){
+        if (!mapSymbol(symbols, symbolCount, ids[i], &(*array)[i]) || !addToSymbolSet(set, (*array)[i]))
+            return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Read the monsters of a snapshot, the merged list is stored in order and copied as it is
+ * @param reader The reader
+ * @param monsters The empty monster table to fill
+ * @param count The number of monsters
+ * @param symbols The symbols of the names
+ * @param symbolCount The number of names
+ * @return 1 on success, 0 if the monsters are damaged
+ */
+static int readMonsters(SnapshotReader *reader, BestiaryTable *monsters, uint32_t count, const Symbol *symbols, uint32_t symbolCount){
+    for (uint32_t i = 0; i < count; i++){
+        const SnapshotMonster *record = takeBytes(reader, sizeof(SnapshotMonster));
+        Symbol monster;
+        if (!record || !mapSymbol(symbols, symbolCount, record->symbol, &monster))
+            return 0;
+
+        size_t entries = (size_t)record->potionCount + record->signCount;
+        const uint32_t *ids = takeBytes(reader, 2*entries*sizeof(uint32_t)); // Potions, signs, then merged
+        Bestiary *b = entryMonster(monsters, monster);
+        if (!ids || b->potionCount + b->signCount > 0 || entries > 0x7fffffff)
+            return 0;
+
+        if (!readEffective(ids, record->potionCount, symbols, symbolCount, &b->effectivePotions, &b->potionSet))
+            return 0;
+        b->potionCount = b->potionCapacity = record->potionCount;
+        if (!readEffective(ids + record->potionCount, record->signCount, symbols, symbolCount, &b->effectiveSigns, &b->signSet))
+            return 0;
+        b->signCount = b->signCapacity = record->signCount;
+
+        if (entries > 0){
+            b->merged = malloc(entries*sizeof(Symbol));
+            if (!b->merged){
+                printf("Memory allocation failed!");
+                exit(EXIT_FAILURE);
+            }
+            b->mergedCapacity = entries;
+            for (size_t j = 0; j < entries; j++){
+                if (!mapSymbol(symbols, symbolCount, ids[entries+j], &b->merged[j]))
+                    return 0;
+            }
+        }
+        b->version++;
+    }
+    return 1;
+}
+
+/**
+ * @brief Fill an empty inventory from the bytes of a snapshot in one pass
+ * @param inventory The empty inventory
+ * @param reader The reader at the start of the snapshot
+ * @param scratch Arena for the symbols of the names and the pairs of the recipes
+ * @return 1 on success, 0 if the snapshot is damaged or of another version
+ */
+static int readSnapshot(Inventory *inventory, SnapshotReader *reader, Arena *scratch){
+    const SnapshotHeader *header = takeBytes(reader, sizeof(SnapshotHeader));
+    if (!header || memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 || header->version != SNAPSHOT_VERSION)
+        return 0;
+
+    const uint64_t *nameEnds = takeBytes(reader, (size_t)header->symbolCount*sizeof(uint64_t));
+    if (!nameEnds || header->nameBytes > reader->size)
+        return 0;
+    const char *names = takeBytes(reader, header->nameBytes + (8 - header->nameBytes % 8) % 8);
+    if (!names)
+        return 0;
+
+    // Names are interned in file order, a snapshot loaded first gets the ids it was saved with
+    Symbol *symbols = arenaAlloc(scratch, ((size_t)header->symbolCount + 1)*sizeof(Symbol));
+    uint64_t start = 0;
+    for (uint32_t i = 0; i < header->symbolCount; i++){
+        if (nameEnds[i] < start || nameEnds[i] > header->nameBytes)
+            return 0;
+        symbols[i] = internSymbolSlice(names + start, nameEnds[i] - start);
+        start = nameEnds[i];
+    }
+
+    return readCounters(reader, inventory->ingredients, header->ingredientCount, symbols, header->symbolCount) &&
+           readCounters(reader, inventory->trophies, header->trophyCount, symbols, header->symbolCount) &&
+           readPotions(reader, inventory, header->potionCount, symbols, header->symbolCount, scratch) && // After the ingredients they count
+           readMonsters(reader, inventory->monsters, header->monsterCount, symbols, header->symbolCount);
+}
+
+/**
+ * @brief Replace an inventory with the content of a snapshot. The snapshot is mapped and read into new
+ * tables in one pass, the inventory only changes if the whole snapshot could be read
+ * @param inventory The inventory
+ * @param path The path of the snapshot
+ * @param scratch Arena for temporary structures, the caller resets it
+ * @return 1 on success, 0 if the snapshot can not be read or is damaged
+ */
+int loadSnapshot(Inventory *inventory, const char *path, Arena *scratch){
+    MappedInput mapped;
+    if (!openMappedInput(&mapped, path))
+        return 0;
+
+    SnapshotReader reader = {mapped.data, mapped.size, 0};
+    Inventory loaded;
+    initializeInventory(&loaded);
+
+    int valid = mapped.data && readSnapshot(&loaded, &reader, scratch);
+    closeMappedInput(&mapped);
+
+    if (!valid){
+        freeInventory(&loaded);
+        return 0;
+    }
+
+    loaded.journal = inventory->journal; // The journal and the snapshot directory are not part of the tables
+    loaded.snapshotDirectory = inventory->snapshotDirectory;
+    freeInventory(inventory);
+    *inventory = loaded;
+    return 1;
+}
@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sorted_index.h"
+
+/**
+ * @brief Initialize an empty index
+ * @param index The index
+ */
+void initializeIndex(SortedIndex *index){
+    index->keys = NULL;
+    index->scratch = NULL;
+    index->size = 0;
+    index->sorted = 0;
+    index->capacity = 0;
+    index->member = NULL;
+    index->memberCapacity = 0;
+}
+
+/**
+ * @brief Add a symbol to the index, nothing happens if it is already there
+ * @param index The index
+ * @param symbol The symbol to add
+ */
+void addToIndex(SortedIndex *index, Symbol symbol){
+    if ((int)symbol < index->memberCapacity && index->member[symbol]) // Already indexed, the common case
+        return;
+
+    if ((int)symbol >= index->memberCapacity){ // Grow the membership array to cover the symbol
+        int newCapacity = index->memberCapacity ? index->memberCapacity : 16;
+        while (newCapacity <= (int)symbol)
+            newCapacity *= 2;
+
+        uint8_t *newMember = realloc(index->member, newCapacity);
+        if (!newMember){
+            printf("Memory reallocation failed!");
+            exit(EXIT_FAILURE);
+        }
+        memset(newMember + index->memberCapacity, 0, newCapacity - index->memberCapacity);
+        index->member = newMember;
+        index->memberCapacity = newCapacity;
+    }
+
+    if (index->size == index->capacity){ // keys and scratch are full
+        index->capacity = index->capacity ? index->capacity*2 : 16;
+        index->keys = realloc(index->keys, index->capacity*sizeof(Symbol));
+        index->scratch = realloc(index->scratch, index->capacity*sizeof(Symbol));
+        if (!index->keys || !index->scratch){
+            printf("Memory reallocation failed!");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    index->member[symbol] = 1;
+    index->keys[index->size++] = symbol; // Appended to the unsorted tail, ordered on the next query
+}
+
+/**
+ * @brief Get the symbols of the index ordered by name. Symbols added since the last call are sorted
+ * and merged into the ordered prefix first, so repeated calls without new symbols cost nothing
+ * @param index The index
+ * @param count Set to the number of symbols
+ * @return The ordered symbols, owned by the index and valid until the next addToIndex
+ */
+const Symbol *orderedSymbols(SortedIndex *index, int *count){
+    *count = index->size;
+    if (index->sorted == index->size) // No new symbols
+        return index->keys;
+
+    Symbol *tail = index->keys + index->sorted;
+    int tailSize = index->size - index->sorted;
+    qsort(tail, tailSize, sizeof(Symbol), compareSymbols); // Only the new symbols are sorted
+
+    // Merge the ordered prefix with the sorted tail into scratch
+    int i = 0, j = 0, k = 0;
+    while (i < index->sorted && j < tailSize){
+        if (strcmp(symbolName(index->keys[i]), symbolName(tail[j])) <= 0)
+            index->scratch[k++] = index->keys[i++];
+        else
+            index->scratch[k++] = tail[j++];
+    }
+    while (i < index->sorted)
+        index->scratch[k++] = index->keys[i++];
+    while (j < tailSize)
+        index->scratch[k++] = tail[j++];
+
+    // Swap the buffers, the old keys become the next scratch
+    Symbol *merged = index->scratch;
+    index->scratch = index->keys;
+    index->keys = merged;
+    index->sorted = index->size;
+
+    return index->keys;
+}
+
+/**
+ * @brief Free the memory owned by an index
+ * @param index The index
+ */
+void freeIndex(SortedIndex *index){
+    free(index->keys);
+    free(index->scratch);
+    free(index->member);
+    initializeIndex(index);
+}
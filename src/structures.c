@@ -1,31 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-
-
-typedef struct{
-    char *key; // String of the pair
-    int count; // Number of the pair
-}Pair;
-
-typedef struct{
-    Pair **array; // array is a pointer to an array of Pair pointers
-    int size; // Number of pairs inside array
-    int capacity;  // Current maximum capacity of array
-}PairArray;
-
-typedef struct{
-    int potionCount; // number of potions in recipe
-    PairArray *recipe; // PairArray
-}Potion;
-
-typedef struct {
-    char **effectivePotions; // Array of strings to hold effective potions
-    int potionCount; // Size of effective potions
-
-    char **effectiveSigns; // Array of strings to hold effective signs
-    int signCount; // Size of effective signs
-}Bestiary;
+#include "structures.h"
 
 
 /**
@@ -34,7 +10,7 @@ typedef struct {
  */
 void resizeArray(PairArray *pairArray){
     int newSize = pairArray->capacity*2;
-    Pair **newArray = realloc(pairArray->array, newSize*sizeof(Pair*)); // Reallocate 2x the old size
+    Pair *newArray = realloc(pairArray->array, newSize*sizeof(Pair)); // Reallocate 2x the old size
 
     if (newArray == NULL){
         printf("Memory reallocation failed!");
@@ -44,4 +20,87 @@ void resizeArray(PairArray *pairArray){
     // Update values
     pairArray->capacity = newSize;
     pairArray->array = newArray;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Initialize an empty set of staged pairs
+ * @param staged The staged pairs
+ */
+void initializeStagedPairs(StagedPairs *staged){
+    staged->pairs = NULL;
+    staged->size = 0;
+    staged->capacity = 0;
+    staged->slots = NULL;
+    staged->slotCapacity = 0;
+}
+
+/**
+ * @brief Fold a pair into the staged pairs. Every key keeps one entry, so the memory depends on the
+ * number of distinct keys and not on the number of pairs
+ * @param staged The staged pairs
+ * @param key The key of the pair
+ * @param count The count of the pair
+ */
+void stagePair(StagedPairs *staged, Symbol key, int count){
+    if ((int)key >= staged->slotCapacity){ // Symbol ids are dense, grow the slot array past the new id
+        int newCapacity = staged->slotCapacity ? staged->slotCapacity : 64;
+        while (newCapacity <= (int)key)
+            newCapacity *= 2;
+
+        int *newSlots = realloc(staged->slots, newCapacity*sizeof(int));
+        if (newSlots == NULL){
+            printf("Memory reallocation failed!");
+            exit(1);
+        }
+        for (int i = staged->slotCapacity; i < newCapacity; i++)
+            newSlots[i] = -1;
+
+        staged->slots = newSlots;
+        staged->slotCapacity = newCapacity;
+    }
+
+    int slot = staged->slots[key];
+    if (slot != -1){ // Key was seen before on this line
+        staged->pairs[slot].total += count;
+        if (count > staged->pairs[slot].largest)
+            staged->pairs[slot].largest = count;
+        return;
+    }
+
+    if (staged->size == staged->capacity){
+        int newCapacity = staged->capacity ? staged->capacity*2 : 16;
+        StagedPair *newPairs = realloc(staged->pairs, newCapacity*sizeof(StagedPair));
+        if (newPairs == NULL){
+            printf("Memory reallocation failed!");
+            exit(1);
+        }
+        staged->pairs = newPairs;
+        staged->capacity = newCapacity;
+    }
+
+    staged->slots[key] = staged->size;
+    staged->pairs[staged->size].key = key;
+    staged->pairs[staged->size].total = count;
+    staged->pairs[staged->size].largest = count;
+    staged->size++;
+}
+
+/**
+ * @brief Drop every staged pair, the memory is kept for the next line
+ * @param staged The staged pairs
+ */
+void clearStagedPairs(StagedPairs *staged){
+    for (int i = 0; i < staged->size; i++)
+        staged->slots[staged->pairs[i].key] = -1;
+    staged->size = 0;
+}
+
+/**
+ * @brief Free the memory of staged pairs
+ * @param staged The staged pairs
+ */
+void freeStagedPairs(StagedPairs *staged){
+    free(staged->pairs);
+    free(staged->slots);
+    initializeStagedPairs(staged);
+}
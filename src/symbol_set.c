@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "symbol_set.h"
+
+/**
+ * @brief Spread a symbol id over the slots, ids are dense so the multiplication mixes the low bits
+ * @param symbol The symbol
+ * @param capacity The capacity of the set
+ * @return The first slot to probe
+ */
+static int homeSlot(Symbol symbol, int capacity){
+    return (int)((symbol * 2654435769u) & (uint32_t)(capacity-1));
+}
+
+/**
+ * @brief Place a symbol that is not in the set, there must be a free slot
+ * @param slots The slots
+ * @param capacity The capacity of the slots
+ * @param symbol The symbol
+ */
+static void placeSymbol(Symbol *slots, int capacity, Symbol symbol){
+    int i = homeSlot(symbol, capacity);
+    while (slots[i] != NO_SYMBOL)
+        i = (i+1) & (capacity-1);
+    slots[i] = symbol;
+}
+
+/**
+ * @brief Double the capacity of a set and place every symbol again
+ * @param set The set
+ */
+static void growSymbolSet(SymbolSet *set){
+    int newCapacity = set->capacity ? set->capacity*2 : SYMBOL_SET_INITIAL_CAPACITY;
+    Symbol *newSlots = malloc(newCapacity*sizeof(Symbol));
+
+    if (newSlots == NULL){
+        printf("Memory allocation failed!");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < newCapacity; i++)
+        newSlots[i] = NO_SYMBOL;
+
+    for (int i = 0; i < set->capacity; i++){
+        if (set->slots[i] != NO_SYMBOL)
+            placeSymbol(newSlots, newCapacity, set->slots[i]);
+    }
+
+    free(set->slots);
+    set->slots = newSlots;
+    set->capacity = newCapacity;
+}
+
+/**
+ * @brief Add a symbol to a set
+ * @param set The set
+ * @param symbol The symbol
+ * @return 1 if the symbol was added, 0 if it was already in the set
+ */
+int addToSymbolSet(SymbolSet *set, Symbol symbol){
+    if (symbolSetContains(set, symbol))
+        return 0;
+
+    if (2*(set->size+1) > set->capacity) // Keep probes short
+        growSymbolSet(set);
+
+    placeSymbol(set->slots, set->capacity, symbol);
+    set->size++;
+    return 1;
+}
+
+/**
+ * @brief Check if a symbol is in a set
+ * @param set The set
+ * @param symbol The symbol
+ * @return 1 if the symbol is in the set, 0 otherwise
+ */
+int symbolSetContains(const SymbolSet *set, Symbol symbol){
+    if (set->size == 0)
+        return 0;
+
+    for (int i = homeSlot(symbol, set->capacity); set->slots[i] != NO_SYMBOL; i = (i+1) & (set->capacity-1)){
+        if (set->slots[i] == symbol)
+            return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Free the slots of a set, the set is empty afterwards
+ * @param set The set
+ */
+void freeSymbolSet(SymbolSet *set){
+    free(set->slots);
+    set->slots = NULL;
+    set->capacity = 0;
+    set->size = 0;
+}
@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symbols.h"
+#include "typed_maps.h"
+#include "concurrent_map.h"
+
+#define INITIAL_SYMBOL_CAPACITY 64
+
+/*
+ * Names are interned by one thread at a time, the thread that executes commands. While it is the only
+ * thread, names live in a HashMap. The first call to registerSymbolReader moves them into a ConcurrentMap,
+ * where other threads may look names up with findSymbolSlice while the executor interns. The executor
+ * looks names up without interning them with lookupSymbolSlice, in either map.
+ */
+static SymbolMap *symbolMap = NULL; // Name to symbol, owns the name strings until the names are shared
+static ConcurrentMap sharedMap; // Name to symbol once another thread reads, owns the name strings
+static int shared = 0; // sharedMap replaced symbolMap
+static int ownReader = -1; // Reader slot of the interning thread in sharedMap
+static const char **names = NULL; // Symbol to name, points into the keys of the map
+static int count = 0; // Number of interned names
+static int capacity = 0; // Capacity of names
+static long long rehashNanos = 0; // Time symbol maps that were released spent moving keys while rehashing
+static long long longestRehashStep = 0; // Longest single migration step of those maps
+
+/**
+ * @brief Intern a name. Every distinct name gets the next dense symbol the first time it is seen
+ * @param name The name to intern
+ * @return The symbol of the name
+ */
+Symbol internSymbol(const char *name){
+    return internSymbolSlice(name, strlen(name));
+}
+
+/**
+ * @brief Give a new name the next symbol
+ * @param key The name, owned by the map
+ * @return The symbol of the name
+ */
+static Symbol addName(const char *key){
+    if (count == capacity){ // names array is full
+        capacity = capacity ? capacity*2 : INITIAL_SYMBOL_CAPACITY;
+        names = realloc(names, capacity*sizeof(char *));
+        if (!names){
+            printf("Memory reallocation failed!");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    names[count] = key; // Share the key the map already copied
+    return count++;
+}
+
+/**
+ * @brief Intern a name given as a slice of a larger string, such as a token of an input line
+ * @param name The first character of the name, it does not need to be NUL terminated
+ * @param length The length of the name
+ * @return The symbol of the name
+ */
+Symbol internSymbolSlice(const char *name, size_t length){
+    if (shared){
+        Symbol symbol = count; // Symbol of the name if it is new
+        const char *key;
+        if (!concurrentFindOrInsert(&sharedMap, name, length, &symbol, &symbol, &key)) // Name is already interned
+            return symbol;
+        return addName(key);
+    }
+
+    if (!symbolMap){ // First call, create the table
+        symbolMap = malloc(sizeof(SymbolMap));
+        if (!symbolMap){
+            printf("Memory allocation failed!");
+            exit(EXIT_FAILURE);
+        }
+        initializeMapSymbol(symbolMap, INITIAL_SYMBOL_CAPACITY);
+    }
+
+    int inserted;
+    Symbol *symbol = findOrInsertSliceSymbol(symbolMap, name, length, &inserted); // One probe finds or claims the slot
+    if (!inserted) // Name is already interned
+        return *symbol;
+
+    *symbol = addName(KEY_OF_VALUE(symbol));
+    return *symbol;
+}
+
+/**
+ * @brief Add the rehash timings of symbolMap to the totals before the map is released
+ */
+static void keepRehashStats(void){
+    if (!symbolMap)
+        return;
+    rehashNanos += symbolMap->base.migrationNanos;
+    if (symbolMap->base.maxMigrationStepNanos > longestRehashStep)
+        longestRehashStep = symbolMap->base.maxMigrationStepNanos;
+}
+
+/**
+ * @brief Move every name into the ConcurrentMap, the symbols stay the same
+ */
+static void shareSymbols(void){
+    initializeConcurrentMap(&sharedMap, count > INITIAL_SYMBOL_CAPACITY ? count : INITIAL_SYMBOL_CAPACITY, sizeof(Symbol));
+    for (int i = 0; i < count; i++){
+        Symbol symbol = i;
+        concurrentFindOrInsert(&sharedMap, names[i], strlen(names[i]), &symbol, NULL, &names[i]);
+    }
+
+    keepRehashStats();
+    freeHashMapSymbol(symbolMap);
+    symbolMap = NULL;
+    shared = 1;
+    ownReader = registerMapReader(&sharedMap);
+}
+
+/**
+ * @brief Give a thread that looks names up with findSymbolSlice its reader slot. Call it before the thread
+ * starts or from the interning thread
+ * @return The reader slot
+ */
+int registerSymbolReader(void){
+    if (!shared)
+        shareSymbols();
+    return registerMapReader(&sharedMap);
+}
+
+/**
+ * @brief Look a name up without interning it, safe while another thread interns
+ * @param reader The reader slot of the calling thread, see registerSymbolReader
+ * @param name The first character of the name, it does not need to be NUL terminated
+ * @param length The length of the name
+ * @return The symbol of the name, NO_SYMBOL if it was never interned
+ */
+Symbol findSymbolSlice(int reader, const char *name, size_t length){
+    Symbol symbol;
+    if (!concurrentGet(&sharedMap, reader, name, length, &symbol))
+        return NO_SYMBOL;
+    return symbol;
+}
+
+/**
+ * @brief Look a name up without interning it, from the interning thread. Queries use it so that the names
+ * they ask about are not kept forever
+ * @param name The first character of the name, it does not need to be NUL terminated
+ * @param length The length of the name
+ * @return The symbol of the name, NO_SYMBOL if it was never interned
+ */
+Symbol lookupSymbolSlice(const char *name, size_t length){
+    if (shared)
+        return findSymbolSlice(ownReader, name, length);
+    if (!symbolMap) // Nothing was interned yet
+        return NO_SYMBOL;
+
+    Symbol *symbol = getSliceSymbol(symbolMap, name, length);
+    return symbol ? *symbol : NO_SYMBOL;
+}
+
+/**
+ * @brief Get the name of a symbol
+ * @param symbol The symbol
+ * @return The interned name
+ */
+const char *symbolName(Symbol symbol){
+    return names[symbol];
+}
+
+/**
+ * @brief Get the number of interned names
+ * @return The number of symbols
+ */
+int symbolCount(void){
+    return count;
+}
+
+/**
+ * @brief Compare two symbols by their names for qsort
+ * @param symbol_ptr_1 The first symbol
+ * @param symbol_ptr_2 The second symbol
+ * @return The result of strcmp on the names
+ */
+int compareSymbols(const void *symbol_ptr_1, const void *symbol_ptr_2){
+    Symbol symbol_1 = *(const Symbol *)symbol_ptr_1;
+    Symbol symbol_2 = *(const Symbol *)symbol_ptr_2;
+
+    return strcmp(names[symbol_1], names[symbol_2]);
+}
+
+/**
+ * @brief Get how long the symbol map spent on incremental rehashing since the start, the longest step is
+ * the most a single intern waited for it
+ * @param totalNanos Set to the time spent moving keys between tables, in nanoseconds
+ * @param longestStepNanos Set to the longest single migration step, in nanoseconds
+ */
+void symbolRehashStats(long long *totalNanos, long long *longestStepNanos){
+    *totalNanos = rehashNanos;
+    *longestStepNanos = longestRehashStep;
+    if (symbolMap){
+        *totalNanos += symbolMap->base.migrationNanos;
+        if (symbolMap->base.maxMigrationStepNanos > *longestStepNanos)
+            *longestStepNanos = symbolMap->base.maxMigrationStepNanos;
+    }
+}
+
+/**
+ * @brief Free every interned name
+ */
+void freeSymbols(void){
+    if (shared)
+        freeConcurrentMap(&sharedMap, NULL);
+    else{
+        keepRehashStats();
+        freeHashMapSymbol(symbolMap);
+    }
+    free(names);
+
+    symbolMap = NULL;
+    shared = 0;
+    ownReader = -1;
+    names = NULL;
+    count = 0;
+    capacity = 0;
+}
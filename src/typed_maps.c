@@ -0,0 +1,82 @@
+#include "typed_maps.h"
+#include "helper_methods.h"
+
+/**
+ * @brief Counters and symbols own no memory, nothing to free
+ * @param value The value
+ */
+static void freeNothing(void *value){
+    (void)value;
+}
+
+DEFINE_TYPED_MAP(SymbolMap, Symbol, Symbol, freeNothing)
+
+DEFINE_SYMBOL_TABLE(CounterTable, Counter, int64_t, freeNothing)
+DEFINE_SYMBOL_TABLE(PotionTable, Potion, Potion, freePotion)
+DEFINE_SYMBOL_TABLE(BestiaryTable, Monster, Bestiary, freeBestiary)
+
+/**
+ * @brief Add a delta to a counter in place, a counter that was never written starts from 0
+ * @param counters The counter table
+ * @param key The symbol to count
+ * @param delta The amount to add, negative to remove
+ * @return The new value of the counter
+ */
+int64_t addToCounter(CounterTable *counters, Symbol key, int64_t delta){
+    int64_t *count = entryCounter(counters, key);
+    int wasZero = *count == 0;
+
+    *count += delta;
+
+    counters->total += delta;
+    counters->version++;
+    counters->nonzero += (*count != 0) - !wasZero; // Counters that leave or reach 0 change the number of nonzero entries
+
+    if (counters->changed)
+        counters->changed(counters->observer, key);
+    return *count;
+}
+
+/**
+ * @brief Subtract a multiple of the folded ingredients of a recipe from a counter table in one pass, the
+ * table changes version once. Every key must already have a counter, as the ingredients of a learned
+ * recipe do
+ * @param counters The counter table
+ * @param ingredients The folded ingredients
+ * @param size The number of ingredients
+ * @param times How many times every total is subtracted
+ */
+void removeIngredients(CounterTable *counters, const StagedPair *ingredients, int size, int64_t times){
+    for (int i = 0; i < size; i++){
+        int64_t *count = &counters->entries[ingredients[i].key];
+        int64_t amount = ingredients[i].total * times;
+        int wasZero = *count == 0;
+
+        *count -= amount;
+        counters->total -= amount;
+        counters->nonzero += (*count != 0) - !wasZero;
+
+        if (counters->changed)
+            counters->changed(counters->observer, ingredients[i].key);
+    }
+    counters->version++;
+}
+
+/**
+ * @brief Add a delta to the brewed amount of a potion in place
+ * @param potions The potion table
+ * @param key The symbol of the potion
+ * @param delta The amount to add, negative to remove
+ * @return The new amount of the potion
+ */
+int64_t addToPotion(PotionTable *potions, Symbol key, int64_t delta){
+    Potion *p = entryPotion(potions, key);
+    int wasZero = p->potionCount == 0;
+
+    p->potionCount += delta;
+
+    potions->total += delta;
+    potions->version++;
+    potions->nonzero += (p->potionCount != 0) - !wasZero;
+    return p->potionCount;
+}